@@ -0,0 +1,89 @@
+# jpico_add_assets(<target>
+#     [NAMESPACE <ns>]
+#     [FONT  <name> <file.bdf|file.ttf> [SIZE <px>] [RANGES <spec>]]...
+#     [IMAGE <name> <file.png> [ENCODING auto|raw|rle|palette] [KEY <rgb565>]
+#                              [ALPHA a8|a4]]...
+# )
+#
+# converts fonts and images into constexpr headers at build time. each asset
+# becomes <assets/<name>.hpp> on the target's include path, defining
+# <ns>::<name> (default namespace `assets`). the target must link
+# jpico_graphics. the per-asset flash footprint is printed as each header is
+# generated.
+
+find_package(Python3 REQUIRED COMPONENTS Interpreter)
+
+set(JPICO_ASSETS_TOOL ${CMAKE_CURRENT_LIST_DIR}/../tools/jpico_assets.py
+    CACHE INTERNAL "jpico asset compiler")
+
+function(_jpico_asset_rule out_dir ns out_var kind name source)
+  cmake_parse_arguments(A "" "SIZE;RANGES;ENCODING;KEY;ALPHA" "" ${ARGN})
+  get_filename_component(source ${source} ABSOLUTE
+                         BASE_DIR ${CMAKE_CURRENT_SOURCE_DIR})
+
+  set(opts)
+  if(kind STREQUAL "FONT")
+    set(sub font)
+    if(A_SIZE)
+      list(APPEND opts --size ${A_SIZE})
+    endif()
+    if(A_RANGES)
+      list(APPEND opts --ranges ${A_RANGES})
+    endif()
+  else()
+    set(sub image)
+    if(A_ENCODING)
+      list(APPEND opts --encoding ${A_ENCODING})
+    endif()
+    if(A_KEY)
+      list(APPEND opts --key ${A_KEY})
+    endif()
+    if(A_ALPHA)
+      list(APPEND opts --alpha ${A_ALPHA})
+    endif()
+  endif()
+
+  set(header ${out_dir}/assets/${name}.hpp)
+  add_custom_command(
+      OUTPUT ${header}
+      COMMAND ${Python3_EXECUTABLE} ${JPICO_ASSETS_TOOL} ${sub}
+              --name ${name} --source ${source} --output ${header}
+              --namespace ${ns} ${opts}
+      DEPENDS ${source} ${JPICO_ASSETS_TOOL}
+      COMMENT "jpico_assets: ${name}"
+      VERBATIM
+  )
+  set(${out_var} ${header} PARENT_SCOPE)
+endfunction()
+
+function(jpico_add_assets target)
+  set(args ${ARGN})
+  set(ns assets)
+  list(FIND args NAMESPACE i)
+  if(NOT i EQUAL -1)
+    math(EXPR j "${i} + 1")
+    list(GET args ${j} ns)
+    list(REMOVE_AT args ${i} ${j})
+  endif()
+
+  set(out_dir ${CMAKE_CURRENT_BINARY_DIR}/jpico_assets/${target})
+  set(headers)
+  set(entry)
+  foreach(arg IN LISTS args ITEMS FONT)
+    if(arg STREQUAL "FONT" OR arg STREQUAL "IMAGE")
+      if(entry)
+        _jpico_asset_rule(${out_dir} ${ns} header ${entry})
+        list(APPEND headers ${header})
+      endif()
+      set(entry ${arg})
+    elseif(NOT entry)
+      message(FATAL_ERROR "jpico_add_assets: expected FONT or IMAGE, got ${arg}")
+    else()
+      list(APPEND entry ${arg})
+    endif()
+  endforeach()
+
+  add_custom_target(${target}_assets DEPENDS ${headers})
+  add_dependencies(${target} ${target}_assets)
+  target_include_directories(${target} PRIVATE ${out_dir})
+endfunction()
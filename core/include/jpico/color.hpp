@@ -20,6 +20,17 @@ constexpr u8 rgb565_b(u16 c) {
   return static_cast<u8>((c & 0x1F) * 255 / 31);
 }
 
+// alpha blend, 0 keeps bg and 255 gives fg. both colors are spread into
+// one word as 00000gggggg00000rrrrr000000bbbbb so the three channels are
+// scaled by a single multiply; alpha is reduced to 5 bits (0..32).
+constexpr u16 blend565(u16 fg, u16 bg, u8 alpha) {
+  u32 a = (alpha + 4u) >> 3;
+  u32 f = (fg | (static_cast<u32>(fg) << 16)) & 0x07E0F81Fu;
+  u32 b = (bg | (static_cast<u32>(bg) << 16)) & 0x07E0F81Fu;
+  u32 r = (b + (((f - b) * a) >> 5)) & 0x07E0F81Fu;
+  return static_cast<u16>(r | (r >> 16));
+}
+
 struct color {
   u16 raw = 0;
 
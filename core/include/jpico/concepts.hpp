@@ -1,7 +1,9 @@
 #pragma once
 
 #include <concepts>
+#include <jpico/result.hpp>
 #include <jpico/types.hpp>
+#include <span>
 
 namespace jpico {
 
@@ -17,6 +19,64 @@ concept display =
       { d.blit(x, y, w, h, data) } -> std::same_as<void>;
     };
 
+// a display that can scroll its contents in hardware. `scroll_to` moves the
+// visible start of the scroll area; frame memory itself is untouched.
+template <typename T>
+concept scrollable_display = display<T> && requires(T d, u16 lines) {
+  { d.set_scroll_area(lines, lines) } -> std::same_as<result<void>>;
+  { d.scroll_to(lines) } -> std::same_as<void>;
+};
+
+// a display that can take a sub-rectangle of a larger buffer in one
+// transfer: rows of w pixels, `stride` pixels apart.
+template <typename T>
+concept strided_display =
+    display<T> && requires(T d, u16 v, const u16* data, usize stride) {
+      { d.blit(v, v, v, v, data, stride) } -> std::same_as<void>;
+    };
+
+// a display that takes scattered pixels in bulk, cheaper than a pixel()
+// call each: the points of a line or circle, say. order within a call is
+// not kept, except that a later point_color for the same point wins.
+template <typename T>
+concept batch_display =
+    display<T> && requires(T d, std::span<const point> pts,
+                           std::span<const point_color> colored, u16 color) {
+      { d.pixels(pts, color) } -> std::same_as<void>;
+      { d.pixels(colored) } -> std::same_as<void>;
+    };
+
+// a display that also takes rgb565 already in wire order (each pixel high
+// byte first in memory) and sends it as plain bytes, rows `stride` pixels
+// apart. canvas flushes rgb565_be framebuffers through it.
+template <typename T>
+concept be_display =
+    display<T> && requires(T d, u16 v, const u16* data, usize stride) {
+      { d.blit_be(v, v, v, v, data, stride) } -> std::same_as<void>;
+    };
+
+// a display whose frame memory can be read back: a w x h rectangle as
+// rgb565 in row order. canvas can blend and take screenshots through it
+// without a framebuffer.
+template <typename T>
+concept readable_display =
+    display<T> && requires(T d, u16 v, std::span<u16> out) {
+      { d.read_rect(v, v, v, v, out) } -> std::same_as<result<void>>;
+    };
+
+// a display that takes one window's pixels piecemeal, for producers that
+// make them a line or a block at a time: begin_window() opens the window,
+// push() sends the next pixels in row order, end_window() closes it.
+// nothing else may be drawn between begin_window() and end_window(), and
+// push() is done with the caller's pixels when it returns.
+template <typename T>
+concept stream_display =
+    display<T> && requires(T d, u16 v, std::span<const u16> px) {
+      { d.begin_window(v, v, v, v) } -> std::same_as<void>;
+      { d.push(px) } -> std::same_as<void>;
+      { d.end_window() } -> std::same_as<void>;
+    };
+
 // any chip that communicates over SPI with chip-select semantics.
 template <typename T>
 concept spi_device = requires(T d) {
@@ -2,7 +2,9 @@
 
 #include <jpico/color.hpp>
 #include <jpico/concepts.hpp>
+#include <jpico/format.hpp>
 #include <jpico/log.hpp>
 #include <jpico/platform.hpp>
 #include <jpico/result.hpp>
+#include <jpico/stats.hpp>
 #include <jpico/types.hpp>
@@ -0,0 +1,464 @@
+#pragma once
+
+#include <concepts>
+#include <cstdio>
+#include <cstring>
+#include <span>
+#include <string_view>
+#include <type_traits>
+#include <jpico/types.hpp>
+
+// std::format-style output without the heap, varargs or printf. the format
+// string is parsed and checked against the argument types at compile time;
+// at run time the pieces are written straight into a sink.
+//
+//   format_to(sink, "{} = {:>6.2}", name, fixed{raw, 16});
+//
+// fields: {[:[[fill]align][+][0][width][.precision][type]]}
+//   integers    d x X b     precision not allowed
+//   fixed       f           precision = decimals (default 2)
+//   decimal     f           digits come from the value
+//   strings     s           precision = max characters
+//   char, bool  c, s
+// alignment is one of < ^ >; numbers default right, text left. "{{" and
+// "}}" print a brace. argument indices are not supported.
+
+namespace jpico {
+
+// signed fixed-point value: raw / 2^frac_bits
+struct fixed {
+  i32 raw;
+  u8 frac_bits;
+};
+
+// integer scaled by 10^places: {2345, 2} prints 23.45
+struct decimal {
+  i32 value;
+  u8 places;
+};
+
+template <typename S>
+concept format_sink = requires(S& s, const char* p, usize n) { s.write(p, n); };
+
+// fills a caller-provided buffer and keeps it nul-terminated. output that
+// doesn't fit is dropped and flagged.
+class buffer_sink {
+ public:
+  explicit buffer_sink(std::span<char> buf)
+      : buf_{buf.data()}, cap_{buf.empty() ? 0 : buf.size() - 1} {
+    if (!buf.empty()) buf_[0] = '\0';
+  }
+
+  void write(const char* p, usize n) {
+    usize k = n < cap_ - len_ ? n : cap_ - len_;
+    if (!k) {
+      truncated_ |= n > 0;
+      return;
+    }
+    std::memcpy(buf_ + len_, p, k);
+    len_ += k;
+    buf_[len_] = '\0';
+    truncated_ |= k < n;
+  }
+
+  std::string_view view() const { return {buf_, len_}; }
+  const char* c_str() const { return buf_; }
+  usize size() const { return len_; }
+  bool truncated() const { return truncated_; }
+
+ private:
+  char* buf_;
+  usize cap_;
+  usize len_ = 0;
+  bool truncated_ = false;
+};
+
+// measures output without storing it
+struct counting_sink {
+  usize count = 0;
+  void write(const char*, usize n) { count += n; }
+};
+
+// straight to stdout with fwrite
+struct stdout_sink {
+  void write(const char* p, usize n) { std::fwrite(p, 1, n, stdout); }
+};
+
+namespace detail::fmt {
+
+enum class arg_kind : u8 {
+  none,
+  integer,
+  boolean,
+  character,
+  string,
+  fixed_point,
+  decimal_point,
+};
+
+template <typename T>
+consteval arg_kind kind_of() {
+  using U = std::remove_cvref_t<T>;
+  if constexpr (std::is_same_v<U, bool>) {
+    return arg_kind::boolean;
+  } else if constexpr (std::is_same_v<U, char>) {
+    return arg_kind::character;
+  } else if constexpr (std::is_integral_v<U>) {
+    return arg_kind::integer;
+  } else if constexpr (std::is_same_v<U, fixed>) {
+    return arg_kind::fixed_point;
+  } else if constexpr (std::is_same_v<U, decimal>) {
+    return arg_kind::decimal_point;
+  } else if constexpr (std::is_convertible_v<const U&, std::string_view>) {
+    return arg_kind::string;
+  } else {
+    return arg_kind::none;
+  }
+}
+
+struct spec {
+  char fill = ' ';
+  char align = 0;  // 0 for the type's default
+  char type = 0;
+  bool plus = false;
+  bool zero = false;
+  u8 width = 0;
+  u8 precision = 0xFF;  // not given
+};
+
+// literal text before a field (braces still doubled) and the field's spec
+struct piece {
+  u16 text_begin = 0;
+  u16 text_end = 0;
+  spec field;
+};
+
+// not constexpr on purpose: reaching it during constant evaluation stops
+// compilation with the message in the diagnostic
+inline void format_error(const char*) {}
+
+consteval bool one_of(char c, std::string_view set) {
+  return set.find(c) != std::string_view::npos;
+}
+
+consteval void check(const spec& s, arg_kind k) {
+  switch (k) {
+    case arg_kind::none:
+      format_error("argument type can't be formatted");
+      break;
+    case arg_kind::integer:
+      if (!one_of(s.type, std::string_view{"\0dxXb", 5}))
+        format_error("integers take d, x, X or b");
+      if (s.precision != 0xFF) format_error("integers take no precision");
+      break;
+    case arg_kind::boolean:
+    case arg_kind::character:
+      if (!one_of(s.type, {k == arg_kind::boolean ? "\0s" : "\0c", 2}))
+        format_error("wrong type for bool or char");
+      if (s.precision != 0xFF || s.plus || s.zero)
+        format_error("bool and char take only fill, align and width");
+      break;
+    case arg_kind::string:
+      if (!one_of(s.type, std::string_view{"\0s", 2}))
+        format_error("strings take s");
+      if (s.plus || s.zero) format_error("strings take no sign or zero pad");
+      break;
+    case arg_kind::fixed_point:
+    case arg_kind::decimal_point:
+      if (!one_of(s.type, std::string_view{"\0f", 2}))
+        format_error("fixed and decimal take f");
+      if (s.precision != 0xFF &&
+          (k == arg_kind::decimal_point || s.precision > 9))
+        format_error("precision is 0-9 and only for fixed");
+      break;
+  }
+}
+
+}  // namespace detail::fmt
+
+template <typename... Args>
+class basic_format_string {
+ public:
+  static constexpr usize field_count = sizeof...(Args);
+
+  template <usize N>
+  consteval basic_format_string(const char (&s)[N]) : text_{s, N - 1} {
+    using namespace detail::fmt;
+    constexpr arg_kind kinds[] = {kind_of<Args>()..., arg_kind::none};
+    const char* p = s;
+    usize n = N - 1, field = 0, lit = 0;
+    for (usize i = 0; i < n;) {
+      if (p[i] == '}') {
+        if (p[i + 1] != '}') format_error("unmatched '}'");
+        i += 2;
+        continue;
+      }
+      if (p[i] != '{') {
+        ++i;
+        continue;
+      }
+      if (p[i + 1] == '{') {
+        i += 2;
+        continue;
+      }
+      if (field == field_count) format_error("more fields than arguments");
+      pieces_[field].text_begin = static_cast<u16>(lit);
+      pieces_[field].text_end = static_cast<u16>(i);
+      ++i;
+      spec sp;
+      if (p[i] == ':') i = parse_spec(p, i + 1, sp);
+      if (p[i] != '}') format_error("bad field, expected '}'");
+      check(sp, kinds[field]);
+      pieces_[field++].field = sp;
+      lit = ++i;
+    }
+    if (field != field_count) format_error("more arguments than fields");
+    pieces_[field_count].text_begin = static_cast<u16>(lit);
+    pieces_[field_count].text_end = static_cast<u16>(n);
+  }
+
+  constexpr std::string_view get() const { return text_; }
+
+  // literal text before field i (i == field_count: the tail)
+  constexpr std::string_view literal(usize i) const {
+    return text_.substr(pieces_[i].text_begin,
+                        pieces_[i].text_end - pieces_[i].text_begin);
+  }
+
+  constexpr const detail::fmt::spec& field(usize i) const {
+    return pieces_[i].field;
+  }
+
+ private:
+  static consteval usize parse_spec(const char* p, usize i,
+                                    detail::fmt::spec& sp) {
+    using detail::fmt::one_of;
+    if (p[i] && p[i] != '}' && one_of(p[i + 1], "<>^")) {
+      sp.fill = p[i];
+      sp.align = p[i + 1];
+      i += 2;
+    } else if (one_of(p[i], "<>^")) {
+      sp.align = p[i++];
+    }
+    if (p[i] == '+') {
+      sp.plus = true;
+      ++i;
+    }
+    if (p[i] == '0') {
+      sp.zero = true;
+      ++i;
+    }
+    u32 width = 0;
+    while (p[i] >= '0' && p[i] <= '9') width = width * 10 + (p[i++] - '0');
+    if (width > 255) detail::fmt::format_error("width over 255");
+    sp.width = static_cast<u8>(width);
+    if (p[i] == '.') {
+      u32 prec = 0;
+      if (p[++i] < '0' || p[i] > '9')
+        detail::fmt::format_error("precision needs digits");
+      while (p[i] >= '0' && p[i] <= '9') prec = prec * 10 + (p[i++] - '0');
+      if (prec > 254) detail::fmt::format_error("precision over 254");
+      sp.precision = static_cast<u8>(prec);
+    }
+    if (p[i] && p[i] != '}') sp.type = p[i++];
+    return i;
+  }
+
+  std::string_view text_;
+  detail::fmt::piece pieces_[sizeof...(Args) + 1];
+};
+
+// arguments are deduced from the call, never from the string
+template <typename... Args>
+using format_string = basic_format_string<std::type_identity_t<Args>...>;
+
+namespace detail::fmt {
+
+// literal text with doubled braces collapsed
+template <format_sink S>
+void write_literal(S& out, std::string_view text) {
+  usize start = 0;
+  for (usize i = 0; i < text.size(); ++i) {
+    if (text[i] != '{' && text[i] != '}') continue;
+    out.write(text.data() + start, i + 1 - start);
+    start = ++i + 1;
+  }
+  if (start < text.size()) out.write(text.data() + start, text.size() - start);
+}
+
+template <format_sink S>
+void pad(S& out, char fill, usize n) {
+  char run[16];
+  std::memset(run, fill, sizeof(run));
+  while (n) {
+    usize k = n < sizeof(run) ? n : sizeof(run);
+    out.write(run, k);
+    n -= k;
+  }
+}
+
+// sign or prefix plus body, padded out to the field width
+template <format_sink S>
+void write_field(S& out, const spec& sp, char default_align,
+                 std::string_view prefix, std::string_view body) {
+  usize len = prefix.size() + body.size();
+  usize padding = sp.width > len ? sp.width - len : 0;
+  if (sp.zero && !sp.align) {
+    out.write(prefix.data(), prefix.size());
+    pad(out, '0', padding);
+    out.write(body.data(), body.size());
+    return;
+  }
+  char a = sp.align ? sp.align : default_align;
+  usize before = a == '<' ? 0 : a == '^' ? padding / 2 : padding;
+  pad(out, sp.fill, before);
+  out.write(prefix.data(), prefix.size());
+  out.write(body.data(), body.size());
+  pad(out, sp.fill, padding - before);
+}
+
+// digits of v in base, written backwards ending at end. 32-bit values
+// take the cheap division path.
+inline char* put_digits(char* end, u64 v, u8 base, bool upper) {
+  const char* digits = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+  if (v <= 0xFFFFFFFFu) {
+    u32 w = static_cast<u32>(v);
+    do {
+      *--end = digits[w % base];
+      w /= base;
+    } while (w);
+    return end;
+  }
+  do {
+    *--end = digits[v % base];
+    v /= base;
+  } while (v);
+  return end;
+}
+
+// exactly n decimal digits of v, zero-filled, written backwards
+inline char* put_fraction(char* end, u32 v, u8 n) {
+  for (u8 i = 0; i < n; ++i, v /= 10)
+    *--end = static_cast<char>('0' + v % 10);
+  return end;
+}
+
+inline constexpr u32 pow10[] = {1,         10,        100,     1000,
+                                10000,     100000,    1000000, 10000000,
+                                100000000, 1000000000};
+
+inline std::string_view sign(bool negative, const spec& sp) {
+  return negative ? "-" : sp.plus ? "+" : "";
+}
+
+template <format_sink S, std::integral T>
+void write_arg(S& out, const spec& sp, T v) {
+  char buf[64];
+  char* end = buf + sizeof(buf);
+  bool neg = false;
+  u64 mag;
+  if constexpr (std::is_signed_v<T>) {
+    neg = v < 0;
+    mag = neg ? 0 - static_cast<u64>(v) : static_cast<u64>(v);
+  } else {
+    mag = v;
+  }
+  u8 base = sp.type == 'x' || sp.type == 'X' ? 16 : sp.type == 'b' ? 2 : 10;
+  char* p = put_digits(end, mag, base, sp.type == 'X');
+  write_field(out, sp, '>', sign(neg, sp), {p, static_cast<usize>(end - p)});
+}
+
+template <format_sink S>
+void write_arg(S& out, const spec& sp, bool v) {
+  write_field(out, sp, '<', {}, v ? "true" : "false");
+}
+
+template <format_sink S>
+void write_arg(S& out, const spec& sp, char v) {
+  write_field(out, sp, '<', {}, {&v, 1});
+}
+
+template <format_sink S>
+void write_arg(S& out, const spec& sp, std::string_view v) {
+  if (sp.precision != 0xFF && v.size() > sp.precision)
+    v = v.substr(0, sp.precision);
+  write_field(out, sp, '<', {}, v);
+}
+
+// int part, then '.' and `places` fraction digits unless places is 0
+template <format_sink S>
+void write_point(S& out, const spec& sp, bool neg, u32 ip, u32 frac,
+                 u8 places) {
+  char buf[24];
+  char* end = buf + sizeof(buf);
+  char* p = end;
+  if (places) {
+    p = put_fraction(p, frac, places);
+    *--p = '.';
+  }
+  p = put_digits(p, ip, 10, false);
+  write_field(out, sp, '>', sign(neg && (ip || frac), sp),
+              {p, static_cast<usize>(end - p)});
+}
+
+template <format_sink S>
+void write_arg(S& out, const spec& sp, fixed v) {
+  u8 places = sp.precision == 0xFF ? 2 : sp.precision;
+  u8 fb = v.frac_bits > 31 ? 31 : v.frac_bits;
+  bool neg = v.raw < 0;
+  u32 mag = neg ? 0u - static_cast<u32>(v.raw) : static_cast<u32>(v.raw);
+  u32 ip = mag >> fb;
+  u64 frac = mag & ((u64{1} << fb) - 1);
+  // fraction scaled to `places` digits, rounded half up
+  u64 half = fb ? u64{1} << (fb - 1) : 0;
+  u32 f = static_cast<u32>((frac * pow10[places] + half) >> fb);
+  if (f >= pow10[places]) {
+    ++ip;
+    f -= pow10[places];
+  }
+  write_point(out, sp, neg, ip, f, places);
+}
+
+template <format_sink S>
+void write_arg(S& out, const spec& sp, decimal v) {
+  u8 places = v.places > 9 ? 9 : v.places;
+  bool neg = v.value < 0;
+  u32 mag = neg ? 0u - static_cast<u32>(v.value) : static_cast<u32>(v.value);
+  write_point(out, sp, neg, mag / pow10[places], mag % pow10[places], places);
+}
+
+template <format_sink S, typename T>
+void write_any(S& out, const spec& sp, const T& v) {
+  constexpr arg_kind k = kind_of<T>();
+  if constexpr (k == arg_kind::string) {
+    write_arg(out, sp, std::string_view{v});
+  } else if constexpr (k == arg_kind::integer) {
+    write_arg<S, std::remove_cvref_t<T>>(out, sp, v);
+  } else {
+    write_arg(out, sp, v);
+  }
+}
+
+}  // namespace detail::fmt
+
+template <format_sink S, typename... Args>
+void format_to(S& out, format_string<Args...> fmt, const Args&... args) {
+  [[maybe_unused]] usize i = 0;
+  (
+      [&] {
+        detail::fmt::write_literal(out, fmt.literal(i));
+        detail::fmt::write_any(out, fmt.field(i), args);
+        ++i;
+      }(),
+      ...);
+  detail::fmt::write_literal(out, fmt.literal(sizeof...(Args)));
+}
+
+template <typename... Args>
+usize formatted_size(format_string<Args...> fmt, const Args&... args) {
+  counting_sink out;
+  format_to(out, fmt, args...);
+  return out.count;
+}
+
+}  // namespace jpico
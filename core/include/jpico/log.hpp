@@ -1,6 +1,8 @@
 #pragma once
 
 #include <cstdio>
+#include <cstring>
+#include <jpico/format.hpp>
 #include <jpico/types.hpp>
 
 namespace jpico::log {
@@ -39,40 +41,68 @@ inline constexpr const char* level_tag(level l) {
   }
 }
 
+// gathers a message so it reaches stdout in one write
+class line_sink {
+ public:
+  void write(const char* p, usize n) {
+    while (n) {
+      if (len_ == sizeof(buf_)) flush();
+      usize k = n < sizeof(buf_) - len_ ? n : sizeof(buf_) - len_;
+      std::memcpy(buf_ + len_, p, k);
+      len_ += k;
+      p += k;
+      n -= k;
+    }
+  }
+
+  void flush() {
+    std::fwrite(buf_, 1, len_, stdout);
+    len_ = 0;
+  }
+
+ private:
+  char buf_[96];
+  usize len_ = 0;
+};
+
 template <level L, typename... Args>
-inline void emit(const char* fmt, Args... args) {
+inline void emit(format_string<Args...> fmt, const Args&... args) {
   if constexpr (L >= min_level) {
-    std::printf("%s ", level_tag(L));
-    std::printf(fmt, args...);
-    std::printf("\n");
+    line_sink out;
+    out.write(level_tag(L), 5);
+    out.write(" ", 1);
+    format_to(out, fmt, args...);
+    out.write("\n", 1);
+    out.flush();
   }
 }
 
 }  // namespace detail
 
+// messages use jpico/format.hpp syntax: log::info("{}x{}", w, h)
 template <typename... Args>
-inline void trace(const char* fmt, Args... args) {
-  detail::emit<level::trace>(fmt, args...);
+inline void trace(format_string<Args...> fmt, const Args&... args) {
+  detail::emit<level::trace, Args...>(fmt, args...);
 }
 
 template <typename... Args>
-inline void debug(const char* fmt, Args... args) {
-  detail::emit<level::debug>(fmt, args...);
+inline void debug(format_string<Args...> fmt, const Args&... args) {
+  detail::emit<level::debug, Args...>(fmt, args...);
 }
 
 template <typename... Args>
-inline void info(const char* fmt, Args... args) {
-  detail::emit<level::info>(fmt, args...);
+inline void info(format_string<Args...> fmt, const Args&... args) {
+  detail::emit<level::info, Args...>(fmt, args...);
 }
 
 template <typename... Args>
-inline void warn(const char* fmt, Args... args) {
-  detail::emit<level::warn>(fmt, args...);
+inline void warn(format_string<Args...> fmt, const Args&... args) {
+  detail::emit<level::warn, Args...>(fmt, args...);
 }
 
 template <typename... Args>
-inline void error(const char* fmt, Args... args) {
-  detail::emit<level::error>(fmt, args...);
+inline void error(format_string<Args...> fmt, const Args&... args) {
+  detail::emit<level::error, Args...>(fmt, args...);
 }
 
 }  // namespace jpico::log
@@ -1,7 +1,17 @@
 #pragma once
 
+// 1 when building for the chip, 0 for host builds (simulation, tests)
+#if (defined(PICO_ON_DEVICE) && PICO_ON_DEVICE) || defined(PICO_RP2040) || \
+    defined(PICO_RP2350)
+#define JPICO_ON_DEVICE 1
+#else
+#define JPICO_ON_DEVICE 0
+#endif
+
 namespace jpico::platform {
 
+inline constexpr bool on_device = JPICO_ON_DEVICE;
+
 #if defined(PICO_RP2350)
 inline constexpr bool is_rp2350 = true;
 #else
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <atomic>
+#include <jpico/types.hpp>
+
+namespace jpico {
+
+// lock-free single-producer single-consumer ring, safe between the two
+// cores (or two threads). only plain 32-bit atomic loads and stores are
+// used, so it works on cores without atomic read-modify-write. N must be a
+// power of two.
+template <typename T, usize N>
+class spsc_queue {
+  static_assert(N && (N & (N - 1)) == 0, "capacity must be a power of two");
+
+ public:
+  // producer side. false when full.
+  bool push(const T& item) {
+    u32 head = head_.load(std::memory_order_relaxed);
+    if (head - tail_.load(std::memory_order_acquire) == N) return false;
+    items_[head & (N - 1)] = item;
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  // consumer side. false when empty.
+  bool pop(T& out) {
+    u32 tail = tail_.load(std::memory_order_relaxed);
+    if (tail == head_.load(std::memory_order_acquire)) return false;
+    out = items_[tail & (N - 1)];
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool empty() const {
+    return head_.load(std::memory_order_acquire) ==
+           tail_.load(std::memory_order_acquire);
+  }
+
+  static constexpr usize capacity() { return N; }
+
+ private:
+  std::atomic<u32> head_{0};
+  std::atomic<u32> tail_{0};
+  T items_[N] = {};
+};
+
+}  // namespace jpico
@@ -0,0 +1,71 @@
+#pragma once
+
+// opt-in instrumentation: frame timing on the canvas, traffic counters on
+// buses and display drivers. off unless JPICO_STATS is 1 (cmake option
+// JPICO_ENABLE_STATS); when off the counters are never written and the
+// clock is never read, so the recording calls compile to nothing.
+
+#include <jpico/platform.hpp>
+#include <jpico/types.hpp>
+
+#ifndef JPICO_STATS
+#define JPICO_STATS 0
+#endif
+
+#if JPICO_STATS && JPICO_ON_DEVICE
+#include "hardware/timer.h"
+#elif JPICO_STATS
+#include <chrono>
+#endif
+
+namespace jpico {
+
+inline constexpr bool stats_enabled = JPICO_STATS;
+
+// microseconds since boot, wrapping every ~71 minutes; differences of two
+// readings stay correct across the wrap. always 0 with stats off.
+inline u32 stats_now_us() {
+#if JPICO_STATS && JPICO_ON_DEVICE
+  return time_us_32();
+#elif JPICO_STATS
+  using namespace std::chrono;
+  return static_cast<u32>(
+      duration_cast<microseconds>(steady_clock::now().time_since_epoch())
+          .count());
+#else
+  return 0;
+#endif
+}
+
+// bytes moved over a bus since the last reset
+struct bus_stats {
+  u32 bytes = 0;
+  u32 transfers = 0;  // sdk calls
+
+  void record(usize n) {
+    if constexpr (stats_enabled) {
+      bytes += static_cast<u32>(n);
+      ++transfers;
+    }
+  }
+};
+
+// what a display driver sent to the panel since the last reset
+struct display_stats {
+  u32 commands = 0;  // command bytes, address windows included
+  u32 windows = 0;   // address windows opened (full-frame pushes count one)
+  u32 pixels = 0;    // pixels written
+
+  void record_command() {
+    if constexpr (stats_enabled) ++commands;
+  }
+
+  void record_window(u32 n) {
+    if constexpr (stats_enabled) {
+      ++windows;
+      pixels += n;
+    }
+  }
+};
+
+}  // namespace jpico
@@ -31,6 +31,12 @@ struct point {
   }
 };
 
+// one pixel of a batch with its own color
+struct point_color {
+  point p;
+  u16 color = 0;
+};
+
 struct size {
   u16 w = 0;
   u16 h = 0;
@@ -62,6 +68,37 @@ struct rect {
     return p.x >= origin.x && p.x < right() && p.y >= origin.y &&
            p.y < bottom();
   }
+
+  constexpr bool empty() const { return dims.w == 0 || dims.h == 0; }
+
+  constexpr bool intersects(const rect& o) const {
+    return !empty() && !o.empty() && o.origin.x < right() &&
+           origin.x < o.right() && o.origin.y < bottom() &&
+           origin.y < o.bottom();
+  }
+
+  // overlap of both rects, or an empty rect when they are disjoint
+  constexpr rect intersection(const rect& o) const {
+    if (!intersects(o)) return {};
+    i16 x0 = origin.x > o.origin.x ? origin.x : o.origin.x;
+    i16 y0 = origin.y > o.origin.y ? origin.y : o.origin.y;
+    i16 x1 = right() < o.right() ? right() : o.right();
+    i16 y1 = bottom() < o.bottom() ? bottom() : o.bottom();
+    return {{x0, y0},
+            {static_cast<u16>(x1 - x0), static_cast<u16>(y1 - y0)}};
+  }
+
+  // smallest rect covering both; an empty operand is ignored
+  constexpr rect united(const rect& o) const {
+    if (o.empty()) return *this;
+    if (empty()) return o;
+    i16 x0 = origin.x < o.origin.x ? origin.x : o.origin.x;
+    i16 y0 = origin.y < o.origin.y ? origin.y : o.origin.y;
+    i16 x1 = right() > o.right() ? right() : o.right();
+    i16 y1 = bottom() > o.bottom() ? bottom() : o.bottom();
+    return {{x0, y0},
+            {static_cast<u16>(x1 - x0), static_cast<u16>(y1 - y0)}};
+  }
 };
 
 }  // namespace jpico
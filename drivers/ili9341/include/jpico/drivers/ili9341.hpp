@@ -1,8 +1,10 @@
 #pragma once
 
 #include <jpico/core.hpp>
+#include <jpico/hal/dma.hpp>
 #include <jpico/hal/gpio.hpp>
 #include <jpico/hal/spi_bus.hpp>
+#include <memory>
 
 namespace jpico::drivers {
 
@@ -14,6 +16,10 @@ inline constexpr u8 DISPON = 0x29;
 inline constexpr u8 CASET = 0x2A;
 inline constexpr u8 PASET = 0x2B;
 inline constexpr u8 RAMWR = 0x2C;
+inline constexpr u8 RAMRD = 0x2E;
+inline constexpr u8 VSCRDEF = 0x33;
+inline constexpr u8 TEOFF = 0x34;
+inline constexpr u8 TEON = 0x35;
 inline constexpr u8 MADCTL = 0x36;
 inline constexpr u8 VSCRSADD = 0x37;
 inline constexpr u8 PIXFMT = 0x3A;
@@ -41,6 +47,8 @@ class ili9341 {
  public:
   static constexpr u16 NATIVE_WIDTH = 240;
   static constexpr u16 NATIVE_HEIGHT = 320;
+  // frame memory reads need a 150 ns serial clock period
+  static constexpr u32 READ_FREQ = 6'000'000;
 
   ili9341(hal::spi_bus& spi, hal::output_pin& cs, hal::output_pin& dc,
           hal::output_pin& rst)
@@ -59,14 +67,95 @@ class ili9341 {
 
   void fill(u16 color);
   void pixel(u16 x, u16 y, u16 color);
+  // many pixels under one chip select. each chunk of points is sorted
+  // into horizontal runs, one address window per run, and column or page
+  // addresses that did not change since the last window are not resent.
+  // points off the panel are dropped.
+  void pixels(std::span<const point> pts, u16 color);
+  void pixels(std::span<const point_color> pts);
   void blit(u16 x, u16 y, u16 w, u16 h, const u16* data);
+  // same, reading rows `stride` pixels apart: one window for a sub-rect
+  void blit(u16 x, u16 y, u16 w, u16 h, const u16* data, usize stride);
+
+  // pixels already in wire order, high byte first (a canvas with an
+  // rgb565_be framebuffer). the spi stays in 8-bit frames throughout.
+  void blit_be(u16 x, u16 y, u16 w, u16 h, const u16* data);
+  void blit_be(u16 x, u16 y, u16 w, u16 h, const u16* data, usize stride);
+
+  // w x h pixels of frame memory into `out`, row by row, as rgb565. one
+  // RAMRD window at READ_FREQ, the bus clock restored after. the panel
+  // sends a dummy byte, then 6-bit r, g, b bytes per pixel. needs the
+  // bus's rx pin wired to the panel's SDO; fails without one, or when
+  // `out` holds fewer than w * h pixels.
+  result<void> read_rect(u16 x, u16 y, u16 w, u16 h, std::span<u16> out);
+
+  // streaming writes: begin_window() asserts cs and leaves the controller
+  // in RAMWR, each push() sends the next pixels of the window in row order,
+  // end_window() waits for the last of them and releases the bus. pushes
+  // may split rows anywhere; the spi belongs to the window until it ends.
+  // with use_dma() a push is copied into one of two line buffers and
+  // queued, returning once the push before it has left, so the caller can
+  // produce line n+1 while line n is on the wire.
+  void begin_window(u16 x, u16 y, u16 w, u16 h);
+  void push(std::span<const u16> px);
+  void end_window();
+  // the line buffer the next push() goes out of (empty without dma).
+  // pixels rendered straight into it and pushed from its start are not
+  // copied.
+  std::span<u16> push_buffer();
+
+  // move fill(), blit_be() and push() payloads by dma instead of the cpu.
+  // `data` streams bytes to the spi; `control` reloads it once per row from
+  // a list of control blocks, so a strided sub-rect is one chained transfer.
+  // the address window still goes out from the cpu: dc has to switch
+  // after the command byte has left the shifter, which dma cannot see.
+  // both channels must outlive the driver. allocates the 2.5 KB block list
+  // and 1.25 KB of push() line buffers.
+  void use_dma(hal::dma_channel& data, hal::dma_channel& control);
+
+  // hardware vertical scrolling. the panel scrolls along its native 320-line
+  // axis, so this only works in the portrait rotations (0 and 2). lines are
+  // in the current orientation: `top` and `bottom` stay fixed, the rest
+  // scrolls.
+  result<void> set_scroll_area(u16 top, u16 bottom);
+  // show the scroll area starting `offset` lines into its frame memory
+  void scroll_to(u16 offset);
+
+  // tearing effect output: with it on, the TE pin goes high for each
+  // vertical blank, the moment a frame can start without tearing. pair it
+  // with a frame_pacer fed by a gpio interrupt on that pin.
+  void set_tearing_effect(bool on);
+  // refresh rate through FRMCTR1: the highest the controller offers at or
+  // below `hz` (61-119 Hz, halved down to 7 Hz by the clock divider).
+  // returns the rate chosen. a full-screen write that starts on TE stays
+  // clear of the scan line if it takes at most two refresh periods; leave
+  // some margin below that (graphics::chase_rate_hz aims for 1.8).
+  result<u8> set_frame_rate(u8 hz);
+  u8 frame_rate() const { return frame_rate_; }
+  // the panel always scans its native rows top to bottom. in rotation 2
+  // frame memory rows meet the glass bottom-up, so a write that chases the
+  // scan goes from the last row up; in the landscape rotations rows run
+  // across the scan and no write order avoids a diagonal tear.
+  bool scan_bottom_up() const { return rotation_ == 2; }
+
+  // panel traffic since the last reset (JPICO_STATS builds). the bytes
+  // themselves are counted on the spi_bus.
+  const display_stats& stats() const { return stats_; }
+  void reset_stats() { stats_ = {}; }
 
  private:
   void hw_reset();
   void write_command(u8 cmd);
   void write_data(const u8* data, usize len);
   void send_command(u8 cmd, const u8* data, u8 len);
-  void set_addr_window(u16 x, u16 y, u16 w, u16 h);
+  // ends with `mem`, the memory write or read command
+  void set_addr_window(u16 x, u16 y, u16 w, u16 h,
+                       u8 mem = ili9341_cmd::RAMWR);
+  bool on_panel(point p) const {
+    return p.x >= 0 && p.y >= 0 && p.x < width_ && p.y < height_;
+  }
+  void dma_rows(const u8* src, usize row_bytes, usize stride_bytes, u16 rows);
+  void finish_dma();
 
   hal::spi_bus& spi_;
   hal::output_pin& cs_;
@@ -76,8 +165,29 @@ class ili9341 {
   u16 width_ = NATIVE_WIDTH;
   u16 height_ = NATIVE_HEIGHT;
   u8 rotation_ = 0;
+  u8 frame_rate_ = 79;  // init's FRMCTR1
+  u16 scroll_top_ = 0;
+  u16 scroll_lines_ = NATIVE_HEIGHT;
+  u16 scroll_bottom_ = 0;
+  display_stats stats_;
+  // CASET and PASET arguments last sent; ~0 after reset, when unknown
+  u32 window_x_ = ~0u;
+  u32 window_y_ = ~0u;
+
+  hal::dma_channel* dma_ = nullptr;
+  hal::dma_channel* dma_control_ = nullptr;
+  std::unique_ptr<u32[]> blocks_;  // {count, read address} per row
+  alignas(4) u16 fill_color_ = 0;  // dma read ring for fill()
+  std::unique_ptr<u16[]> lines_;   // push() line buffers, back to back
+  u8 line_ = 0;                    // the one the next push() fills
 };
 
 static_assert(display<ili9341>);
+static_assert(scrollable_display<ili9341>);
+static_assert(strided_display<ili9341>);
+static_assert(be_display<ili9341>);
+static_assert(batch_display<ili9341>);
+static_assert(stream_display<ili9341>);
+static_assert(readable_display<ili9341>);
 
 }  // namespace jpico::drivers
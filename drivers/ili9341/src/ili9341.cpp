@@ -1,9 +1,21 @@
+#include <algorithm>
 #include <jpico/drivers/ili9341.hpp>
 #include <jpico/hal/time.hpp>
 #include <jpico/log.hpp>
 
 namespace jpico::drivers {
 
+// 8-bit writes into the spi data register, paced by its tx dreq
+static dma_channel_config spi_tx_config(hal::dma_channel& dma,
+                                        spi_inst_t* spi) {
+  dma_channel_config c = dma.default_config();
+  channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
+  channel_config_set_dreq(&c, spi_get_dreq(spi, true));
+  channel_config_set_read_increment(&c, true);
+  channel_config_set_write_increment(&c, false);
+  return c;
+}
+
 static const u8 init_commands[] = {24,
                                    0xEF,
                                    3,
@@ -137,8 +149,10 @@ result<void> ili9341::init() {
 
   width_ = NATIVE_WIDTH;
   height_ = NATIVE_HEIGHT;
+  frame_rate_ = 79;
+  window_x_ = window_y_ = ~0u;
 
-  log::info("ili9341 initialized (%dx%d)", width_, height_);
+  log::info("ili9341 initialized ({}x{})", width_, height_);
   return ok();
 }
 
@@ -186,16 +200,31 @@ void ili9341::fill(u16 color) {
   cs_.low();
   set_addr_window(0, 0, width_, height_);
   dc_.high();
-  spi_.set_format(16, SPI_CPOL_1, SPI_CPHA_1);
 
+  u32 total = static_cast<u32>(width_) * height_;
+  if (dma_) {
+    // 8-bit frames, reading the color's two bytes round a 2-byte ring
+    fill_color_ = __builtin_bswap16(color);
+    dma_channel_config c = spi_tx_config(*dma_, spi_.instance());
+    channel_config_set_ring(&c, false, 1);
+    dma_->transfer(&fill_color_, &spi_get_hw(spi_.instance())->dr, total * 2,
+                   c);
+    dma_->wait();
+    finish_dma();
+    spi_.stats().record(total * 2);
+    cs_.high();
+    return;
+  }
+
+  spi_.set_format(16, SPI_CPOL_1, SPI_CPHA_1);
   constexpr usize row_size = 320;
   u16 row_buffer[row_size];
   for (usize i = 0; i < row_size; i++) row_buffer[i] = color;
 
-  u32 total = static_cast<u32>(width_) * height_;
   while (total > 0) {
     usize chunk = (total > row_size) ? row_size : total;
     spi_write16_blocking(spi_.instance(), row_buffer, chunk);
+    spi_.stats().record(chunk * 2);
     total -= chunk;
   }
   cs_.high();
@@ -207,6 +236,74 @@ void ili9341::pixel(u16 x, u16 y, u16 color) {
   dc_.high();
   spi_.set_format(16, SPI_CPOL_1, SPI_CPHA_1);
   spi_write16_blocking(spi_.instance(), &color, 1);
+  spi_.stats().record(2);
+  cs_.high();
+}
+
+// points are taken pixel_chunk at a time, sorted by row then column
+static constexpr usize pixel_chunk = 64;
+
+static bool row_major(point a, point b) {
+  return a.y != b.y ? a.y < b.y : a.x < b.x;
+}
+
+void ili9341::pixels(std::span<const point> pts, u16 color) {
+  point run[pixel_chunk];
+  u8 bytes[2 * pixel_chunk];
+  for (usize i = 0; i < pixel_chunk; ++i) {
+    bytes[2 * i] = static_cast<u8>(color >> 8);
+    bytes[2 * i + 1] = static_cast<u8>(color);
+  }
+
+  cs_.low();
+  while (!pts.empty()) {
+    usize n = 0;
+    for (; n < pixel_chunk && !pts.empty(); pts = pts.subspan(1)) {
+      if (on_panel(pts.front())) run[n++] = pts.front();
+    }
+    std::sort(run, run + n, row_major);
+    for (usize i = 0; i < n;) {
+      point s = run[i];
+      i16 end = static_cast<i16>(s.x + 1);
+      for (++i; i < n && run[i].y == s.y && run[i].x <= end; ++i) {
+        if (run[i].x == end) ++end;  // equal to end - 1: a repeat
+      }
+      u16 len = static_cast<u16>(end - s.x);
+      set_addr_window(static_cast<u16>(s.x), static_cast<u16>(s.y), len, 1);
+      write_data(bytes, len * 2u);
+    }
+  }
+  cs_.high();
+}
+
+void ili9341::pixels(std::span<const point_color> pts) {
+  point_color run[pixel_chunk];
+  u8 bytes[2 * pixel_chunk];
+
+  cs_.low();
+  while (!pts.empty()) {
+    usize n = 0;
+    for (; n < pixel_chunk && !pts.empty(); pts = pts.subspan(1)) {
+      if (on_panel(pts.front().p)) run[n++] = pts.front();
+    }
+    // stable, so the last of repeated points is the one kept
+    std::stable_sort(run, run + n, [](const point_color& a,
+                                      const point_color& b) {
+      return row_major(a.p, b.p);
+    });
+    for (usize i = 0; i < n;) {
+      point s = run[i].p;
+      u16 len = 0;
+      for (; i < n && run[i].p.y == s.y && run[i].p.x <= s.x + len; ++i) {
+        if (run[i].p.x < s.x + len) --len;  // a repeat replaces the last
+        bytes[2 * len] = static_cast<u8>(run[i].color >> 8);
+        bytes[2 * len + 1] = static_cast<u8>(run[i].color);
+        ++len;
+      }
+      set_addr_window(static_cast<u16>(s.x), static_cast<u16>(s.y), len, 1);
+      write_data(bytes, len * 2u);
+    }
+  }
   cs_.high();
 }
 
@@ -216,41 +313,293 @@ void ili9341::blit(u16 x, u16 y, u16 w, u16 h, const u16* data) {
   dc_.high();
   spi_.set_format(16, SPI_CPOL_1, SPI_CPHA_1);
   spi_write16_blocking(spi_.instance(), data, static_cast<usize>(w) * h);
+  spi_.stats().record(static_cast<usize>(w) * h * 2);
+  cs_.high();
+}
+
+void ili9341::blit(u16 x, u16 y, u16 w, u16 h, const u16* data,
+                   usize stride) {
+  cs_.low();
+  set_addr_window(x, y, w, h);
+  dc_.high();
+  spi_.set_format(16, SPI_CPOL_1, SPI_CPHA_1);
+  for (u16 row = 0; row < h; ++row, data += stride) {
+    spi_write16_blocking(spi_.instance(), data, w);
+    spi_.stats().record(static_cast<usize>(w) * 2);
+  }
+  cs_.high();
+}
+
+void ili9341::blit_be(u16 x, u16 y, u16 w, u16 h, const u16* data) {
+  blit_be(x, y, w, h, data, w);
+}
+
+void ili9341::blit_be(u16 x, u16 y, u16 w, u16 h, const u16* data,
+                      usize stride) {
+  cs_.low();
+  set_addr_window(x, y, w, h);  // leaves the spi in 8-bit frames
+  dc_.high();
+  const u8* bytes = reinterpret_cast<const u8*>(data);
+  usize row = static_cast<usize>(w) * 2;
+  if (dma_) {
+    dma_rows(bytes, row, stride * 2, h);
+    finish_dma();
+  } else if (stride == w) {
+    spi_write_blocking(spi_.instance(), bytes, row * h);
+  } else {
+    for (u16 r = 0; r < h; ++r, bytes += stride * 2) {
+      spi_write_blocking(spi_.instance(), bytes, row);
+    }
+  }
+  spi_.stats().record(row * h);
+  cs_.high();
+}
+
+// pixels converted per read
+static constexpr usize read_chunk = 64;
+
+result<void> ili9341::read_rect(u16 x, u16 y, u16 w, u16 h,
+                                std::span<u16> out) {
+  if (spi_.config().pin_rx == 0xFF) {
+    return fail(error_code::invalid_argument, "read_rect needs the spi rx pin");
+  }
+  usize n = static_cast<usize>(w) * h;
+  if (out.size() < n) {
+    return fail(error_code::invalid_argument, "read_rect buffer too small");
+  }
+  if (!n) return ok();
+
+  spi_inst_t* spi = spi_.instance();
+  u8 rgb[3 * read_chunk];
+  cs_.low();
+  set_addr_window(x, y, w, h, ili9341_cmd::RAMRD);
+  dc_.high();
+  spi_.set_baudrate(READ_FREQ);
+  spi_read_blocking(spi, 0, rgb, 1);  // dummy
+  for (usize i = 0; i < n;) {
+    usize m = std::min(n - i, read_chunk);
+    spi_read_blocking(spi, 0, rgb, m * 3);
+    for (const u8* c = rgb; c < rgb + m * 3; c += 3) {
+      out[i++] = rgb565(c[0], c[1], c[2]);
+    }
+  }
+  cs_.high();  // ends the read
+  spi_.set_baudrate(spi_.config().baudrate);
+  spi_.stats().record(1 + n * 3);
+  return ok();
+}
+
+// pixels per push() line buffer: a row in any rotation
+static constexpr usize stream_line = ili9341::NATIVE_HEIGHT;
+
+void ili9341::begin_window(u16 x, u16 y, u16 w, u16 h) {
+  cs_.low();
+  set_addr_window(x, y, w, h);
+  dc_.high();
+  // 16-bit frames put each pixel on the wire high byte first, for the
+  // cpu and for 16-bit dma alike
+  spi_.set_format(16, SPI_CPOL_1, SPI_CPHA_1);
+}
+
+void ili9341::push(std::span<const u16> px) {
+  spi_inst_t* spi = spi_.instance();
+  spi_.stats().record(px.size() * 2);
+  if (!dma_) {
+    spi_write16_blocking(spi, px.data(), px.size());
+    return;
+  }
+
+  dma_channel_config c = spi_tx_config(*dma_, spi);
+  channel_config_set_transfer_data_size(&c, DMA_SIZE_16);
+  while (!px.empty()) {
+    // the free buffer went out two transfers ago, so it can be refilled
+    // while the other one is still streaming
+    u16* buf = lines_.get() + line_ * stream_line;
+    usize n = std::min(px.size(), stream_line);
+    if (px.data() != buf) std::copy_n(px.data(), n, buf);
+    dma_->wait();
+    dma_->transfer(buf, &spi_get_hw(spi)->dr, static_cast<u32>(n), c);
+    line_ ^= 1;
+    px = px.subspan(n);
+  }
+}
+
+void ili9341::end_window() {
+  if (dma_) {
+    dma_->wait();
+    finish_dma();
+  }
   cs_.high();
 }
 
+std::span<u16> ili9341::push_buffer() {
+  if (!lines_) return {};
+  return {lines_.get() + line_ * stream_line, stream_line};
+}
+
+void ili9341::use_dma(hal::dma_channel& data, hal::dma_channel& control) {
+  dma_ = &data;
+  dma_control_ = &control;
+  blocks_ = std::make_unique<u32[]>(2 * (NATIVE_HEIGHT + 1));
+  lines_ = std::make_unique<u16[]>(2 * stream_line);
+}
+
+result<void> ili9341::set_scroll_area(u16 top, u16 bottom) {
+  if (rotation_ & 1) {
+    return fail(error_code::invalid_argument,
+                "vertical scroll needs a portrait rotation");
+  }
+  if (top + bottom >= NATIVE_HEIGHT) {
+    return fail(error_code::invalid_argument, "no lines left to scroll");
+  }
+
+  // frame memory runs bottom-up in rotation 2, so the fixed areas swap
+  scroll_top_ = rotation_ == 2 ? bottom : top;
+  scroll_bottom_ = rotation_ == 2 ? top : bottom;
+  scroll_lines_ = NATIVE_HEIGHT - top - bottom;
+
+  u8 args[6] = {
+      static_cast<u8>(scroll_top_ >> 8),    static_cast<u8>(scroll_top_),
+      static_cast<u8>(scroll_lines_ >> 8),  static_cast<u8>(scroll_lines_),
+      static_cast<u8>(scroll_bottom_ >> 8), static_cast<u8>(scroll_bottom_),
+  };
+  send_command(ili9341_cmd::VSCRDEF, args, sizeof(args));
+  scroll_to(0);
+  return ok();
+}
+
+void ili9341::scroll_to(u16 offset) {
+  offset %= scroll_lines_;
+  if (rotation_ == 2) offset = (scroll_lines_ - offset) % scroll_lines_;
+  u16 vsp = scroll_top_ + offset;
+
+  u8 args[2] = {static_cast<u8>(vsp >> 8), static_cast<u8>(vsp)};
+  send_command(ili9341_cmd::VSCRSADD, args, sizeof(args));
+}
+
+void ili9341::set_tearing_effect(bool on) {
+  u8 mode = 0x00;  // vertical blank only
+  if (on) {
+    send_command(ili9341_cmd::TEON, &mode, 1);
+  } else {
+    send_command(ili9341_cmd::TEOFF, nullptr, 0);
+  }
+}
+
+// refresh rate for each RTNA from 0x10 at DIVA 0 (fosc / 1)
+static constexpr u8 rtna_hz[16] = {119, 112, 106, 100, 95, 90, 86, 83,
+                                   79,  76,  73,  70,  68, 65, 63, 61};
+
+result<u8> ili9341::set_frame_rate(u8 hz) {
+  for (u8 diva = 0; diva < 4; ++diva) {
+    for (u8 i = 0; i < 16; ++i) {
+      u8 rate = static_cast<u8>(rtna_hz[i] >> diva);
+      if (rate > hz) continue;
+      u8 args[2] = {diva, static_cast<u8>(0x10 + i)};
+      send_command(ili9341_cmd::FRMCTR1, args, sizeof(args));
+      frame_rate_ = rate;
+      return ok(rate);
+    }
+  }
+  return fail(error_code::invalid_argument, "frame rate below 7 Hz");
+}
+
 void ili9341::write_command(u8 cmd) {
   dc_.low();
   spi_.set_format(8, SPI_CPOL_1, SPI_CPHA_1);
   spi_write_blocking(spi_.instance(), &cmd, 1);
+  spi_.stats().record(1);
+  stats_.record_command();
 }
 
 void ili9341::write_data(const u8* data, usize len) {
   dc_.high();
   spi_.set_format(8, SPI_CPOL_1, SPI_CPHA_1);
   spi_write_blocking(spi_.instance(), data, len);
+  spi_.stats().record(len);
 }
 
 void ili9341::send_command(u8 cmd, const u8* data, u8 len) {
   cs_.low();
   write_command(cmd);
-  write_data(data, len);
+  if (len) write_data(data, len);
   cs_.high();
 }
 
-void ili9341::set_addr_window(u16 x, u16 y, u16 w, u16 h) {
+// send `rows` rows of row_bytes, stride_bytes apart, and wait for the dma.
+// evenly packed rows are one transfer; otherwise the control channel
+// writes each row's {count, read address} block into the data channel's
+// alias 3 registers, the second write triggering it, and the data channel
+// chains back for the next block until a null trigger ends the list.
+void ili9341::dma_rows(const u8* src, usize row_bytes, usize stride_bytes,
+                       u16 rows) {
+  spi_inst_t* spi = spi_.instance();
+  dma_channel_config c = spi_tx_config(*dma_, spi);
+  if (rows == 1 || stride_bytes == row_bytes) {
+    dma_->transfer(src, &spi_get_hw(spi)->dr,
+                   static_cast<u32>(row_bytes * rows), c);
+    dma_->wait();
+    return;
+  }
+
+  u32* block = blocks_.get();
+  for (u16 r = 0; r < rows; ++r, src += stride_bytes) {
+    *block++ = static_cast<u32>(row_bytes);
+    *block++ = static_cast<u32>(reinterpret_cast<uintptr_t>(src));
+  }
+  *block++ = 0;
+  *block++ = 0;
+
+  u32 data = static_cast<u32>(dma_->channel());
+  u32 control = static_cast<u32>(dma_control_->channel());
+  channel_config_set_chain_to(&c, control);
+  channel_config_set_irq_quiet(&c, true);
+  dma_->transfer(nullptr, &spi_get_hw(spi)->dr, 0, c, false);
+
+  dma_channel_config k = dma_control_->default_config();
+  channel_config_set_transfer_data_size(&k, DMA_SIZE_32);
+  channel_config_set_read_increment(&k, true);
+  channel_config_set_write_increment(&k, true);
+  channel_config_set_ring(&k, true, 3);  // the two 4-byte registers
+  dma_control_->transfer(blocks_.get(), &dma_hw->ch[data].al3_transfer_count,
+                         2, k);
+
+  // finished once the control channel has read the null block
+  auto end = static_cast<u32>(reinterpret_cast<uintptr_t>(block));
+  while (dma_hw->ch[control].read_addr != end || dma_->busy()) {
+  }
+}
+
+// after a dma payload: wait for the shifter to empty, then drop what the
+// spi clocked in meanwhile and clear the overrun it flagged
+void ili9341::finish_dma() {
+  spi_inst_t* spi = spi_.instance();
+  while (spi_is_busy(spi)) {
+  }
+  while (spi_is_readable(spi)) (void)spi_get_hw(spi)->dr;
+  spi_get_hw(spi)->icr = SPI_SSPICR_RORIC_BITS;
+}
+
+void ili9341::set_addr_window(u16 x, u16 y, u16 w, u16 h, u8 mem) {
   u32 xa = ((u32)x << 16) | (x + w - 1);
   u32 ya = ((u32)y << 16) | (y + h - 1);
-  xa = __builtin_bswap32(xa);
-  ya = __builtin_bswap32(ya);
+  if (mem == ili9341_cmd::RAMWR) stats_.record_window(static_cast<u32>(w) * h);
 
-  write_command(ili9341_cmd::CASET);
-  write_data(reinterpret_cast<const u8*>(&xa), sizeof(xa));
-
-  write_command(ili9341_cmd::PASET);
-  write_data(reinterpret_cast<const u8*>(&ya), sizeof(ya));
+  // the controller keeps both ranges until changed, so skip repeats
+  if (xa != window_x_) {
+    window_x_ = xa;
+    xa = __builtin_bswap32(xa);
+    write_command(ili9341_cmd::CASET);
+    write_data(reinterpret_cast<const u8*>(&xa), sizeof(xa));
+  }
+  if (ya != window_y_) {
+    window_y_ = ya;
+    ya = __builtin_bswap32(ya);
+    write_command(ili9341_cmd::PASET);
+    write_data(reinterpret_cast<const u8*>(&ya), sizeof(ya));
+  }
 
-  write_command(ili9341_cmd::RAMWR);
+  write_command(mem);
 }
 
 }  // namespace jpico::drivers
@@ -60,6 +60,11 @@ class ssd1306 {
   void set_contrast(u8 contrast);
   void invert(bool inv);
 
+  // panel traffic since the last reset (JPICO_STATS builds): each flush is
+  // one window of width x height pixels. bytes are counted on the i2c_bus.
+  const display_stats& stats() const { return stats_; }
+  void reset_stats() { stats_ = {}; }
+
  private:
   void send_cmd(u8 cmd);
   void send_cmd_list(const u8* cmds, usize len);
@@ -69,6 +74,7 @@ class ssd1306 {
   u8 addr_;
   u16 width_;
   u16 height_;
+  display_stats stats_;
 
   u8 buffer_[WIDTH_128 * HEIGHT_64 / 8] = {};
 };
@@ -10,6 +10,7 @@ namespace jpico::drivers {
 void ssd1306::send_cmd(u8 cmd) {
   u8 buf[2] = {0x80, cmd};  // Co=1, D/C#=0
   i2c_.write(addr_, buf);
+  stats_.record_command();
 }
 
 void ssd1306::send_cmd_list(const u8* cmds, usize len) {
@@ -60,7 +61,7 @@ result<void> ssd1306::init() {
 
   send_cmd(0xAF);  // display on
 
-  log::info("ssd1306 initialized (%dx%d)", width_, height_);
+  log::info("ssd1306 initialized ({}x{})", width_, height_);
   return ok();
 }
 
@@ -99,6 +100,7 @@ void ssd1306::flush() {
   };
   send_cmd_list(cmds, sizeof(cmds));
   send_buf(buffer_, buflen);
+  stats_.record_window(static_cast<u32>(width_) * height_);
 }
 
 void ssd1306::set_contrast(u8 contrast) {
@@ -11,7 +11,7 @@ result<void> xpt2046::init() {
   read_channel(xpt2046_cmd::READ_X);
   read_channel(xpt2046_cmd::READ_Y);
 
-  log::info("xpt2046 initialized (screen %dx%d)", screen_w_, screen_h_);
+  log::info("xpt2046 initialized (screen {}x{})", screen_w_, screen_h_);
   return ok();
 }
 
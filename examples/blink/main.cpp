@@ -9,7 +9,7 @@ int main() {
   hal::board_led led;
   auto r = led.init();
   if (!r) {
-    log::error("led init failed: %s", r.error().message);
+    log::error("led init failed: {}", r.error().message);
     return 1;
   }
 
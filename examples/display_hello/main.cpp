@@ -25,7 +25,7 @@ int main() {
 
   auto r = display.init();
   if (!r) {
-    log::error("display init failed: %s", r.error().message);
+    log::error("display init failed: {}", r.error().message);
     while (true) hal::sleep(1000);
   }
 
@@ -39,7 +39,7 @@ int main() {
   canvas.set_text_size(3);
   canvas.print("hello, jpico!\n");
   canvas.set_text_color(colors::green.raw);
-  canvas.printf("display: %dx%d\n", display.width(), display.height());
+  canvas.print("display: {}x{}\n", display.width(), display.height());
   canvas.flush();
 
   while (true) {
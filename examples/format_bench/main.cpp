@@ -0,0 +1,58 @@
+// times format_to against snprintf for the lines the library prints: a
+// status line mixing int, hex and fixed-point fields, and a single int.
+// host only; build it with the examples outside the pico sdk.
+#include <chrono>
+#include <cstdio>
+#include <jpico/format.hpp>
+#include <jpico/platform.hpp>
+
+static_assert(!JPICO_ON_DEVICE, "format_bench is a host program");
+
+using namespace jpico;
+
+namespace {
+
+constexpr int iterations = 5'000'000;
+
+// keeps the results live so the loops are not optimized away
+volatile usize sink = 0;
+
+template <typename Fn>
+double ns_per_call(Fn&& fn) {
+  auto t0 = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; ++i) sink = sink + fn(i);
+  auto t1 = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(t1 - t0).count() /
+         iterations;
+}
+
+}  // namespace
+
+int main() {
+  char buf[64];
+
+  double mixed_fmt = ns_per_call([&](int i) {
+    buffer_sink out{buf};
+    format_to(out, "x={:6} y={:x} t={:.2}", i, i * 7u, fixed{i, 8});
+    return out.size();
+  });
+  double mixed_c = ns_per_call([&](int i) {
+    int n = std::snprintf(buf, sizeof(buf), "x=%6d y=%x t=%.2f", i, i * 7u,
+                          i / 256.0);
+    return static_cast<usize>(n);
+  });
+  double int_fmt = ns_per_call([&](int i) {
+    buffer_sink out{buf};
+    format_to(out, "{}", i);
+    return out.size();
+  });
+  double int_c = ns_per_call([&](int i) {
+    return static_cast<usize>(std::snprintf(buf, sizeof(buf), "%d", i));
+  });
+
+  std::printf("mixed line: format_to %.1f ns, snprintf %.1f ns\n", mixed_fmt,
+              mixed_c);
+  std::printf("single int: format_to %.1f ns, snprintf %.1f ns\n", int_fmt,
+              int_c);
+  return 0;
+}
@@ -20,7 +20,7 @@ int main() {
 
   auto r = oled.init();
   if (!r) {
-    log::error("oled init failed: %s", r.error().message);
+    log::error("oled init failed: {}", r.error().message);
     while (true) hal::sleep(1000);
   }
 
@@ -3,6 +3,7 @@
 #include <jpico/drivers/xpt2046.hpp>
 #include <jpico/graphics/canvas.hpp>
 #include <jpico/hal/hal.hpp>
+#include <jpico/ui/screen.hpp>
 
 using namespace jpico;
 
@@ -31,7 +32,7 @@ int main() {
 
   auto r = display.init();
   if (!r) {
-    log::error("display init failed: %s", r.error().message);
+    log::error("display init failed: {}", r.error().message);
     while (true) hal::sleep(1000);
   }
 
@@ -39,7 +40,7 @@ int main() {
 
   auto t = touch.init();
   if (!t) {
-    log::error("touch init failed: %s", t.error().message);
+    log::error("touch init failed: {}", t.error().message);
     while (true) hal::sleep(1000);
   }
 
@@ -65,47 +66,68 @@ int main() {
   u16 bar_w = display.width() / (palette_count + 1);  // +1 for CLR button
   u16 bar_y = display.height() - 20;
 
-  auto draw_toolbar = [&]() {
-    for (u16 i = 0; i < palette_count; ++i) {
-      canvas.fill_rect(i * bar_w, bar_y, bar_w, 20, palette[i]);
-    }
-    canvas.fill_rect(palette_count * bar_w, bar_y,
-                     display.width() - palette_count * bar_w, 20,
-                     colors::dark_gray.raw);
-    canvas.set_text_color(colors::white.raw);
-    canvas.set_text_size(1);
-    canvas.set_cursor(palette_count * bar_w + 4, bar_y + 6);
-    canvas.print("CLR");
-  };
+  // toolbar widgets; the ui only repaints the buttons that change
+  static u8 ui_memory[1024];
+  ui::arena arena{ui_memory};
+  ui::screen<> toolbar{arena};
+  if (!toolbar.init(display.width(), display.height())) {
+    log::error("ui init failed");
+    while (true) hal::sleep(1000);
+  }
 
-  draw_toolbar();
+  struct paint_state {
+    u16 brush_color = colors::white.raw;
+    bool clear = false;
+  } state;
+
+  for (u16 i = 0; i < palette_count; ++i) {
+    auto b = toolbar.add<ui::button>(
+        rect{{static_cast<i16>(i * bar_w), static_cast<i16>(bar_y)},
+             {bar_w, 20}},
+        "");
+    if (!b) break;
+    (*b)->set_fill(palette[i]);
+    (*b)->on_click(
+        [](ui::widget& w, void* ctx) {
+          static_cast<paint_state*>(ctx)->brush_color =
+              static_cast<ui::button&>(w).fill();
+        },
+        &state);
+  }
+  auto clr = toolbar.add<ui::button>(
+      rect{{static_cast<i16>(palette_count * bar_w), static_cast<i16>(bar_y)},
+           {static_cast<u16>(display.width() - palette_count * bar_w), 20}},
+      "CLR");
+  if (clr) {
+    (*clr)->on_click(
+        [](ui::widget&, void* ctx) {
+          static_cast<paint_state*>(ctx)->clear = true;
+        },
+        &state);
+  }
 
-  u16 brush_color = colors::white.raw;
   constexpr i16 brush_size = 5;
 
   while (true) {
-    u16 z = touch.pressure();
-
-    if (z > 30) {
-      auto p = touch.read();
-
-      if (p.x >= 0 && p.x < display.width() && p.y >= 0 &&
-          p.y < display.height()) {
-        if (p.y >= bar_y) {
-          u16 idx = p.x / bar_w;
-          if (idx < palette_count) {
-            brush_color = palette[idx];
-          } else {
-            canvas.clear();
-            draw_toolbar();
-          }
-        } else {
-          canvas.fill_rect(p.x - brush_size / 2, p.y - brush_size / 2,
-                           brush_size, brush_size, brush_color);
-        }
-      }
+    bool down = touch.touched();
+    point p = down ? touch.read() : point{};
+    if (down) {
+      toolbar.touch_down(p);
+    } else {
+      toolbar.touch_up();
+    }
+
+    if (state.clear) {
+      state.clear = false;
+      toolbar.invalidate({{0, 0}, {display.width(), bar_y}});
+    }
+
+    if (down && p.x >= 0 && p.x < display.width() && p.y >= 0 && p.y < bar_y) {
+      canvas.fill_rect(p.x - brush_size / 2, p.y - brush_size / 2, brush_size,
+                       brush_size, state.brush_color);
     }
 
+    toolbar.update(canvas);
     hal::sleep(10);
   }
 }
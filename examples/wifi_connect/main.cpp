@@ -26,7 +26,7 @@ int main() {
 
   auto init = wifi.init();
   if (!init) {
-    log::error("wifi init failed: %s", init.error().message);
+    log::error("wifi init failed: {}", init.error().message);
     while (true) hal::sleep(1000);
   }
 
@@ -34,10 +34,10 @@ int main() {
 
   auto conn = wifi.connect("YOUR_SSID", "YOUR_PASSWORD", 30000);
   if (!conn) {
-    log::error("connect failed: %s", conn.error().message);
+    log::error("connect failed: {}", conn.error().message);
   } else {
-    log::info("connected! ip: %s", wifi.ip_string());
-    log::info("rssi: %ld dBm", wifi.rssi());
+    log::info("connected! ip: {}", wifi.ip_string());
+    log::info("rssi: {} dBm", wifi.rssi());
   }
 
   while (true) {
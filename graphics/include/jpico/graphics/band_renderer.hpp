@@ -0,0 +1,226 @@
+#pragma once
+#include <atomic>
+#include <jpico/concepts.hpp>
+#include <jpico/graphics/canvas.hpp>
+#include <jpico/graphics/display_list.hpp>
+#include <jpico/platform.hpp>
+#include <jpico/spsc_queue.hpp>
+#include <jpico/types.hpp>
+#include <span>
+
+#if JPICO_ON_DEVICE
+#include "hardware/sync.h"
+#include "pico/multicore.h"
+#else
+#include <thread>
+#endif
+
+namespace jpico::graphics {
+
+namespace detail {
+
+// canvas target for one band. the pixels stay in the band buffer and are
+// sent by the renderer, so nothing here is ever called on purpose.
+template <u16 W, u16 H>
+struct band_surface {
+  u16 width() const { return W; }
+  u16 height() const { return H; }
+  void fill(u16) {}
+  void pixel(u16, u16, u16) {}
+  void blit(u16, u16, u16, u16, const u16*) {}
+};
+
+// sleep until the other core signals, a yield on the host
+inline void wait_for_event() {
+#if JPICO_ON_DEVICE
+  __wfe();
+#else
+  std::this_thread::yield();
+#endif
+}
+
+inline void signal_event() {
+#if JPICO_ON_DEVICE
+  __sev();
+#endif
+}
+
+#if JPICO_ON_DEVICE
+// core1's stack for the worker, in place of the sdk's 2 KB default
+inline constexpr usize core1_stack_bytes = 4096;
+alignas(8) inline u32 core1_stack[core1_stack_bytes / sizeof(u32)];
+#endif
+
+}  // namespace detail
+
+// renders a display_list in horizontal bands of BandH rows on core1 while
+// core0 sends finished bands to the display, so rasterizing and the spi
+// transfer overlap. two band buffers ping-pong between the cores; band
+// descriptors go through a pair of lock-free spsc queues. host builds run
+// the worker on a std::thread.
+//
+// the buffers live in the object (2 * W * BandH pixels), so make it static:
+//
+//   static band_renderer<ili9341, 240, 320> renderer{lcd};
+//   renderer.start();
+//   renderer.render(list);  // or begin_frame(list), then poll() until true
+template <display D, u16 W, u16 H, u16 BandH = 16>
+class band_renderer {
+  static_assert(BandH > 0 && BandH <= H);
+
+ public:
+  static constexpr u16 band_count = (H + BandH - 1) / BandH;
+
+  explicit band_renderer(D& display) : display_{display} {}
+  ~band_renderer() { stop(); }
+
+  band_renderer(const band_renderer&) = delete;
+  band_renderer& operator=(const band_renderer&) = delete;
+
+  // launch the worker on core1. only one renderer can own core1. the
+  // worker gets a 4 KB stack of its own (detail::core1_stack): replaying
+  // a large polygon or a round-capped thick line holds the band canvas,
+  // the list's copy of the vertices and the rasterizer's edge table at
+  // once, about 3 KB, which would overflow the sdk's 2 KB core1 stack.
+  void start() {
+    if (running_.load(std::memory_order_relaxed)) return;
+    running_.store(true, std::memory_order_release);
+#if JPICO_ON_DEVICE
+    active_ = this;
+    multicore_launch_core1_with_stack([] { active_->run_worker(); },
+                                      detail::core1_stack,
+                                      detail::core1_stack_bytes);
+#else
+    worker_ = std::thread([this] { run_worker(); });
+#endif
+  }
+
+  // stop the worker; call between frames
+  void stop() {
+    if (!running_.load(std::memory_order_relaxed)) return;
+    running_.store(false, std::memory_order_release);
+    detail::signal_event();
+#if JPICO_ON_DEVICE
+    multicore_reset_core1();
+    active_ = nullptr;
+#else
+    worker_.join();
+#endif
+  }
+
+  bool running() const { return running_.load(std::memory_order_relaxed); }
+
+  // color each band is cleared to before the list is replayed into it
+  void set_background(u16 color) { background_ = color; }
+
+  // start a frame. `list` must stay unchanged until poll() returns true.
+  // a stream_display gets the whole frame as one window, each band pushed
+  // as it finishes (by dma where the driver has it); the display belongs
+  // to the renderer until the frame is sent.
+  void begin_frame(const display_list& list) {
+    list_ = &list;
+    next_ = 0;
+    sent_ = 0;
+    if constexpr (stream_display<D>) display_.begin_window(0, 0, W, H);
+    dispatch(0);
+    dispatch(1);
+  }
+
+  // send every band core1 has finished and hand its buffer back. cheap
+  // when nothing is ready; returns true once the frame is fully sent.
+  bool poll() {
+    band b;
+    while (finished_.pop(b)) {
+      send(b);
+      ++sent_;
+      dispatch(b.buffer);
+      if constexpr (stream_display<D>) {
+        if (sent_ == band_count) display_.end_window();
+      }
+    }
+    return sent_ == band_count;
+  }
+
+  // blocking frame: begin_frame, then poll until done
+  void render(const display_list& list) {
+    begin_frame(list);
+    while (!poll()) detail::wait_for_event();
+  }
+
+  // worker loop, runs on core1 until stop()
+  void run_worker() {
+    band b;
+    while (running_.load(std::memory_order_acquire)) {
+      if (!pending_.pop(b)) {
+        detail::wait_for_event();
+        continue;
+      }
+      rasterize(b);
+      finished_.push(b);  // at most two bands in flight, never full
+      detail::signal_event();
+    }
+  }
+
+ private:
+  struct band {
+    u16 y;
+    u16 h;
+    u8 buffer;
+  };
+
+  using surface = detail::band_surface<W, BandH>;
+  using storage = static_framebuffer<W, BandH>;
+
+  // bands finish in order, so a stream takes them as they come. push()
+  // has copied the pixels out when it returns, freeing the buffer.
+  void send(const band& b) {
+    const u16* px = buffers_[b.buffer].pixels;
+    if constexpr (stream_display<D>) {
+      display_.push(std::span<const u16>(px, usize{W} * b.h));
+    } else {
+      display_.blit(0, b.y, W, b.h, px);
+    }
+  }
+
+  void dispatch(u8 buffer) {
+    if (next_ == band_count) return;
+    u16 y = static_cast<u16>(next_ * BandH);
+    u16 h = static_cast<u16>(H - y < BandH ? H - y : BandH);
+    pending_.push({y, h, buffer});
+    ++next_;
+    detail::signal_event();
+  }
+
+  // replay the list through a viewport that puts screen row b.y at band
+  // row 0; records outside the band are skipped by the replay clip
+  void rasterize(const band& b) {
+    surface s;
+    canvas<surface, storage> c(s, buffers_[b.buffer]);
+    c.set_clear_color(background_);
+    c.clear();
+    i16 y = static_cast<i16>(b.y);
+    jpico::rect view{{0, static_cast<i16>(-y)},
+                     {W, static_cast<u16>(b.y + b.h)}};
+    if (!c.push_viewport(view)) return;
+    list_->replay(c, {{0, y}, {W, b.h}});
+    c.pop_clip();
+  }
+
+  D& display_;
+  storage buffers_[2];
+  spsc_queue<band, 2> pending_;
+  spsc_queue<band, 2> finished_;
+  std::atomic<bool> running_{false};
+  const display_list* list_ = nullptr;
+  u16 background_ = 0;
+  u16 next_ = 0;
+  u16 sent_ = 0;
+
+#if JPICO_ON_DEVICE
+  static inline band_renderer* active_ = nullptr;
+#else
+  std::thread worker_;
+#endif
+};
+
+}  // namespace jpico::graphics
@@ -1,60 +1,440 @@
 #pragma once
 #include <algorithm>
+#include <bit>
 #include <cstdarg>
 #include <cstdio>
 #include <cstring>
 #include <jpico/color.hpp>
 #include <jpico/concepts.hpp>
+#include <jpico/format.hpp>
 #include <jpico/graphics/font.hpp>
+#include <jpico/graphics/image.hpp>
+#include <jpico/graphics/raster.hpp>
+#include <jpico/graphics/text.hpp>
+#include <jpico/stats.hpp>
 #include <jpico/types.hpp>
 #include <memory>
+#include <span>
+#include <type_traits>
 
 namespace jpico::graphics {
 
-struct image {
-  u16 w;
-  u16 h;
-  const u16* data;  // row-major rgb565 pixels, w * h entries
+// framebuffer storage. in the indexed formats every color handed to the
+// canvas (primitives, text, image pixels) is a palette index, expanded
+// through the palette on flush. rgb565_be takes the same colors as rgb565
+// but stores them byte-swapped, in the order the panel wants them on the
+// wire, so a be_display can send flushes as plain bytes (no 16-bit spi
+// frames, one dma stream). fills swap their color once; copied images are
+// swapped per pixel.
+enum class pixel_format : u8 {
+  rgb565,     // 2 bytes per pixel
+  rgb565_be,  // 2 bytes per pixel, high byte first
+  indexed8,  // 1 byte per pixel, 256-entry palette
+  indexed4,  // 2 pixels per byte (high nibble first), 16-entry palette
+};
 
-  u16 color_key = 0;
-  bool use_color_key = false;
+// image orientation, built like madctl: bit 2 swaps rows and columns,
+// then bits 0 and 1 mirror the result. rotations are clockwise.
+enum class transform : u8 {
+  none = 0,
+  flip_x = 1,  // mirror left-right
+  flip_y = 2,  // mirror top-bottom
+  rot180 = 3,
+  transpose = 4,
+  rot90 = 5,
+  rot270 = 6,
+  transverse = 7,
 };
 
-template <display D>
+enum class scale_filter : u8 {
+  nearest,
+  bilinear,
+};
+
+inline constexpr u8 max_clip_depth = 8;
+
+// hash of `rows` rows of `row_bytes` bytes, `stride` bytes apart. ctx is
+// whatever was registered with the function (e.g. hal::dma_channel for
+// dma_channel::sniff_crc32).
+using tile_hash_fn = u32 (*)(void* ctx, const u8* data, usize stride,
+                             usize row_bytes, u16 rows);
+
+// portable tile hash: fnv-1a over 32-bit words with an extra xor-shift so
+// high bits reach the low ones
+inline u32 hash_rows(void*, const u8* data, usize stride, usize row_bytes,
+                     u16 rows) {
+  u32 h = 2166136261u;
+  for (u16 r = 0; r < rows; ++r, data += stride) {
+    usize i = 0;
+    for (; i + 4 <= row_bytes; i += 4) {
+      u32 w;
+      std::memcpy(&w, data + i, 4);
+      h = (h ^ w) * 16777619u;
+      h ^= h >> 15;
+    }
+    for (; i < row_bytes; ++i) h = (h ^ data[i]) * 16777619u;
+  }
+  return h;
+}
+
+// row order of a full flush. bottom_up sends bands from the last panel
+// row up, for panels whose scan meets frame memory that way round (see
+// frame_pacer).
+enum class flush_order : u8 { top_down, bottom_up };
+
+struct tile_stats {
+  u16 sent = 0;
+  u16 skipped = 0;
+  u16 blits = 0;  // after merging neighbouring tiles
+};
+
+// one frame as the canvas saw it, from the end of the previous frame to
+// the end of this one. only recorded in JPICO_STATS builds.
+struct frame_stats {
+  u32 frame_us = 0;
+  u32 flush_us = 0;     // in flush(), flush_rows() and flush_rect()
+  u32 raster_us = 0;    // the rest: drawing, and the bus in direct mode
+  u32 blits = 0;        // display blit() calls
+  u32 pixel_calls = 0;  // display pixel() and pixels() calls
+  u32 blit_pixels = 0;  // pixels sent by those blits
+  u32 dirty_area = 0;   // framebuffer pixels sent by flushes
+
+  u16 fps() const {
+    return frame_us ? static_cast<u16>(1'000'000 / frame_us) : 0;
+  }
+};
+
+// framebuffer bytes per row
+constexpr usize row_stride(pixel_format format, u16 width) {
+  switch (format) {
+    case pixel_format::rgb565:
+    case pixel_format::rgb565_be:
+      return static_cast<usize>(width) * 2;
+    case pixel_format::indexed8:
+      return width;
+    case pixel_format::indexed4:
+      return (static_cast<usize>(width) + 1) / 2;
+  }
+  return 0;
+}
+
+constexpr bool is_indexed(pixel_format format) {
+  return format == pixel_format::indexed8 || format == pixel_format::indexed4;
+}
+
+// default canvas storage: create_framebuffer() allocates on the heap,
+// sized from the display at that moment
+struct heap_framebuffer {};
+
+// storage for a static_canvas: size and format fixed at compile time so
+// bounds, strides and row loops fold into constants. W x H must match the
+// display's orientation. declare it with static storage duration, e.g.
+//   JPICO_FRAMEBUFFER_SECTION static static_framebuffer<320, 240> fb;
+template <u16 W, u16 H, pixel_format F = pixel_format::rgb565>
+struct static_framebuffer {
+  static constexpr u16 width = W;
+  static constexpr u16 height = H;
+  static constexpr pixel_format format = F;
+  static constexpr usize stride = row_stride(F, W);
+
+  alignas(4) u16 pixels[(stride * H + 1) / 2];
+  u16 line[is_indexed(F) ? W : 1];  // flush expansion buffer
+};
+
+// where static framebuffers go. the default stays in .bss (zeroed, not
+// loaded); define it before including to target another ram region.
+#ifndef JPICO_FRAMEBUFFER_SECTION
+#define JPICO_FRAMEBUFFER_SECTION [[gnu::section(".bss.jpico_framebuffer")]]
+#endif
+
+template <display D, typename Storage = heap_framebuffer>
+class canvas;
+
+template <display D, u16 W, u16 H, pixel_format F = pixel_format::rgb565>
+using static_canvas = canvas<D, static_framebuffer<W, H, F>>;
+
+template <display D, typename Storage>
 class canvas {
  public:
-  explicit canvas(D& display) : display_{display} {}
+  static constexpr bool fixed_size = !std::is_same_v<Storage, heap_framebuffer>;
+
+  explicit canvas(D& display)
+    requires(!fixed_size)
+      : display_{display} {}
+
+  // static canvas: always framebuffered, in `fb`
+  canvas(D& display, Storage& fb)
+    requires fixed_size
+      : display_{display}, framebuffer_{fb.pixels}, line_{fb.line} {}
 
   ~canvas() = default;
 
   canvas(const canvas&) = delete;
   canvas& operator=(const canvas&) = delete;
 
-  void create_framebuffer() {
-    if (!framebuffer_) {
-      usize size = static_cast<usize>(width()) * height();
-      framebuffer_ = std::make_unique<u16[]>(size);
-      clear();
+  void create_framebuffer(pixel_format format = pixel_format::rgb565)
+    requires(!fixed_size)
+  {
+    if (framebuffer_ && format_ == format) return;
+
+    format_ = format;
+    stride_ = row_stride(format_, width());
+    // u16 storage keeps rgb565 rows aligned; indexed rows use it as bytes
+    heap_ = std::make_unique<u16[]>((stride_ * height() + 1) / 2);
+    framebuffer_ = heap_.get();
+    tiles_valid_ = false;
+    if (is_indexed(format_)) {
+      heap_line_ = std::make_unique<u16[]>(width());
+    } else {
+      heap_line_.reset();
+    }
+    line_ = heap_line_.get();
+    clear();
+  }
+
+  void destroy_framebuffer()
+    requires(!fixed_size)
+  {
+    heap_.reset();
+    heap_line_.reset();
+    framebuffer_ = nullptr;
+    line_ = nullptr;
+    format_ = pixel_format::rgb565;
+  }
+
+  constexpr pixel_format format() const {
+    if constexpr (fixed_size) {
+      return Storage::format;
+    } else {
+      return format_;
     }
   }
 
-  void destroy_framebuffer() { framebuffer_.reset(); }
+  // indexed formats only. changing the palette recolors the whole frame on
+  // the next flush without touching the framebuffer.
+  void set_palette(const u16* colors, u16 count, u8 first = 0) {
+    count = std::min<u16>(count, 256 - first);
+    std::copy(colors, colors + count, palette_ + first);
+    framebuffer_dirty_ = true;
+    tiles_valid_ = false;
+  }
+
+  void set_palette_entry(u8 index, u16 color) {
+    palette_[index] = color;
+    framebuffer_dirty_ = true;
+    tiles_valid_ = false;
+  }
+
+  const u16* palette() const { return palette_; }
 
-  void flush() {
+  // tile mode sends changed tiles top down whatever the order
+  void flush(flush_order order = flush_order::top_down) {
     if (framebuffer_ && framebuffer_dirty_) {
-      display_.blit(0, 0, width(), height(), framebuffer_.get());
+      u32 t0 = stats_now_us();
+      // rows are stored in panel order, so a ring offset needs no unrolling
+      if (tile_hashes_) {
+        flush_tiles();
+      } else if (order == flush_order::bottom_up) {
+        for (i16 p = height(); p > 0; p -= scan_band) {
+          i16 n = std::min<i16>(scan_band, p);
+          blit_rows(p - n, n);
+        }
+      } else {
+        blit_rows(0, height());
+      }
       framebuffer_dirty_ = false;
+      flushed_since(t0);
+    }
+    end_frame();
+  }
+
+  // close the current stats frame. flush() does this itself; code that
+  // presents with flush_rect() (ui::screen) or draws straight to the
+  // display calls it once per frame instead. a no-op without JPICO_STATS.
+  void end_frame() {
+    if constexpr (stats_enabled) {
+      u32 now = stats_now_us();
+      frame_.frame_us = now - frame_start_;
+      frame_.raster_us = frame_.frame_us > frame_.flush_us
+                             ? frame_.frame_us - frame_.flush_us
+                             : 0;
+      last_frame_ = frame_;
+      frame_ = {};
+      frame_start_ = now;
     }
   }
 
+  const frame_stats& last_frame_stats() const { return last_frame_; }
+
+  // for code that redraws everything each frame: flush() hashes the
+  // framebuffer in tile x tile blocks and only sends blocks whose hash
+  // changed since the previous flush, merging changed neighbours in a row
+  // of tiles into one blit. the first flush after enabling (or after a
+  // format or palette change) sends everything. a hash collision leaves a
+  // stale tile until it changes again. tile is rounded up to a multiple
+  // of 4 (at least 8), so tile edges fall on whole bytes in indexed4 and
+  // on whole words for a dma hash.
+  void enable_tile_flush(u16 tile = 32, tile_hash_fn hash = hash_rows,
+                         void* ctx = nullptr) {
+    tile_ = static_cast<u16>((std::max<u16>(tile, 8) + 3) & ~3u);
+    tile_cols_ = static_cast<u16>((width() + tile_ - 1) / tile_);
+    tile_rows_ = static_cast<u16>((height() + tile_ - 1) / tile_);
+    tile_hashes_ = std::make_unique<u32[]>(tile_cols_ * tile_rows_);
+    tile_hash_ = hash;
+    tile_ctx_ = ctx;
+    tiles_valid_ = false;
+  }
+
+  void disable_tile_flush() { tile_hashes_.reset(); }
+
+  // tiles sent and skipped by the last tile-mode flush
+  const tile_stats& last_flush_stats() const { return tile_stats_; }
+
+  // push only rows [y, y + h) of the framebuffer. leaves the dirty flag
+  // alone, so a later flush() still sends everything.
+  void flush_rows(i16 y, i16 h) {
+    if (!framebuffer_) return;
+    u32 t0 = stats_now_us();
+    i16 y0 = std::max<i16>(0, y);
+    i16 y1 = std::min<i16>(height(), y + h);
+    while (y0 < y1) {
+      i16 p = panel_row(y0);
+      i16 n = std::min<i16>(y1 - y0, height() - p);
+      blit_rows(p, n);
+      y0 += n;
+    }
+    flushed_since(t0);
+  }
+
+  // push only the part of the framebuffer under r, e.g. a damaged region.
+  // like flush_rows, the dirty flag is left alone.
+  void flush_rect(jpico::rect r) {
+    if (!framebuffer_) return;
+    r = r.intersection(screen_rect());
+    if (r.empty()) return;
+    u32 t0 = stats_now_us();
+    i16 y0 = r.y(), y1 = r.bottom();
+    while (y0 < y1) {
+      i16 p = panel_row(y0);
+      i16 n = std::min<i16>(y1 - y0, height() - p);
+      blit_block(r.x(), p, static_cast<i16>(r.width()), n);
+      y0 += n;
+    }
+    flushed_since(t0);
+  }
+
+  // without a framebuffer, blend by reading the panel back rather than
+  // drawing only the mostly opaque pixels. every blended row then costs a
+  // read at the display's slower read clock. turns itself off if a read
+  // fails (no rx pin, say).
+  void set_readback(bool on)
+    requires readable_display<D>
+  {
+    readback_ = on;
+  }
+
+  // the screen as a plain ppm (P3) to `out`: text, so it survives the crlf
+  // translation of usb stdio. reads the framebuffer, or without one the
+  // panel itself on a readable_display.
+  template <format_sink S>
+  result<void> screenshot(S& out) {
+    if constexpr (!readable_display<D>) {
+      if (!framebuffer_) {
+        return fail(error_code::not_initialized,
+                    "screenshot needs a framebuffer");
+      }
+    }
+    format_to(out, "P3\n{} {}\n255\n", width(), height());
+    u16 px[line_chunk];
+    char text[12 * line_chunk + 1];
+    for (i16 y = 0; y < height(); ++y) {
+      for (i16 x = 0; x < width(); x += line_chunk) {
+        i16 n = std::min<i16>(line_chunk, width() - x);
+        auto r = read_row(y, x, n, px);
+        if (!r) return r;
+        buffer_sink line{text};
+        for (i16 i = 0; i < n; ++i) {
+          format_to(line, "{} {} {} ", rgb565_r(px[i]), rgb565_g(px[i]),
+                    rgb565_b(px[i]));
+        }
+        format_to(line, "\n");
+        out.write(line.c_str(), line.size());
+      }
+    }
+    return ok();
+  }
+
+  result<void> screenshot() {
+    stdout_sink out;
+    auto r = screenshot(out);
+    std::fflush(stdout);
+    return r;
+  }
+
+  // console mode: scroll_up() moves the panel's scroll start address
+  // instead of the pixels and only the newly exposed lines are sent. the
+  // framebuffer becomes a ring of rows offset by the scroll position.
+  result<void> enable_hw_scroll()
+    requires scrollable_display<D>
+  {
+    auto r = display_.set_scroll_area(0, 0);
+    if (!r) return r;
+    scroll_offset_ = 0;
+    hw_scroll_ = true;
+    return ok();
+  }
+
+  // back to plain scrolling. a framebuffer is unrolled and re-sent on the
+  // next flush; without one the screen is cleared.
+  void disable_hw_scroll()
+    requires scrollable_display<D>
+  {
+    if (!hw_scroll_) return;
+    if (framebuffer_) {
+      u8* base = reinterpret_cast<u8*>(framebuffer_);
+      std::rotate(base, base + scroll_offset_ * stride(),
+                  base + height() * stride());
+      framebuffer_dirty_ = true;
+      tiles_valid_ = false;
+    }
+    scroll_offset_ = 0;
+    hw_scroll_ = false;
+    display_.scroll_to(0);
+    if (!framebuffer_) display_.fill(clear_color_);
+  }
+
+  // clip stack. push_clip narrows drawing to r (in current coordinates)
+  // intersected with the active clip; push_viewport also moves the origin
+  // to r's top-left so the region draws in its own coordinates. both return
+  // false when the stack is full (max_clip_depth), in which case nothing is
+  // pushed and the matching pop_clip must be skipped.
+  bool push_clip(jpico::rect r) { return push_clip_state(r, {}); }
+  bool push_viewport(jpico::rect r) { return push_clip_state(r, r.origin); }
+
+  void pop_clip() {
+    if (clip_depth_) --clip_depth_;
+  }
+
+  // active clip in current coordinates
+  jpico::rect clip_rect() const {
+    jpico::rect c = clip();
+    return {c.origin - origin(), c.dims};
+  }
+
+  // screen position of the current coordinate origin
+  point origin() const {
+    return clip_depth_ ? clip_stack_[clip_depth_ - 1].origin : point{};
+  }
+
   void clear() { fill(clear_color_); }
 
+  // fills the active clip, the whole screen when none is pushed
   void fill(u16 color) {
-    if (framebuffer_) {
-      usize size = static_cast<usize>(width()) * height();
-      for (usize i = 0; i < size; ++i) {
-        framebuffer_[i] = color;
-      }
+    if (clip_depth_) {
+      jpico::rect c = clip();
+      for (i16 y = c.y(); y < c.bottom(); ++y) span(y, c.x(), c.right(), color);
+    } else if (framebuffer_) {
+      for (i16 y = 0; y < height(); ++y) fb_span(y, 0, width(), color);
       framebuffer_dirty_ = true;
     } else {
       display_.fill(color);
@@ -64,17 +444,54 @@ class canvas {
   void set_clear_color(u16 color) { clear_color_ = color; }
 
   void pixel(i16 x, i16 y, u16 color) {
-    if (x < 0 || x >= width() || y < 0 || y >= height()) return;
+    point o = origin();
+    x += o.x;
+    y += o.y;
+    if (!clip().contains({x, y})) return;
 
     if (framebuffer_) {
-      framebuffer_[y * width() + x] = color;
+      fb_put(x, y, color);
       framebuffer_dirty_ = true;
     } else {
-      display_.pixel(static_cast<u16>(x), static_cast<u16>(y), color);
+      send_pixel(static_cast<u16>(x), static_cast<u16>(panel_row(y)), color);
     }
   }
 
+  // scattered pixels in current coordinates. on a batch_display without
+  // a framebuffer they are clipped and handed over a chunk at a time.
+  void pixels(std::span<const point> pts, u16 color) {
+    pixel_batch b{*this, color};
+    for (point p : pts) b.put(p.x, p.y);
+  }
+
+  void pixels(std::span<const point_color> pts) {
+    if constexpr (batch_display<D>) {
+      if (!framebuffer_) {
+        point_color buf[line_chunk];
+        usize n = 0;
+        point o = origin();
+        jpico::rect c = clip();
+        for (const point_color& pc : pts) {
+          point p = pc.p + o;
+          if (!c.contains(p)) continue;
+          buf[n++] = {{p.x, panel_row(p.y)}, pc.color};
+          if (n == line_chunk) {
+            send_pixels(std::span<const point_color>(buf, n));
+            n = 0;
+          }
+        }
+        if (n) send_pixels(std::span<const point_color>(buf, n));
+        return;
+      }
+    }
+    for (const point_color& pc : pts) pixel(pc.p.x, pc.p.y, pc.color);
+  }
+
   void line(i16 x0, i16 y0, i16 x1, i16 y1, u16 color) {
+    if (!visible(std::min(x0, x1), std::min(y0, y1), std::max(x0, x1),
+                 std::max(y0, y1)))
+      return;
+    pixel_batch b{*this, color};
     bool steep = std::abs(y1 - y0) > std::abs(x1 - x0);
     if (steep) {
       std::swap(x0, y0);
@@ -90,9 +507,9 @@ class canvas {
 
     for (; x0 <= x1; x0++) {
       if (steep)
-        pixel(y0, x0, color);
+        b.put(y0, x0);
       else
-        pixel(x0, y0, color);
+        b.put(x0, y0);
       err -= dy;
       if (err < 0) {
         y0 += ystep;
@@ -101,43 +518,58 @@ class canvas {
     }
   }
 
+  // thick line as a filled polygon, with butt, square or round caps
+  void line(i16 x0, i16 y0, i16 x1, i16 y1, u16 color, u16 thickness,
+            line_cap cap = line_cap::butt) {
+    if (thickness <= 1 && cap != line_cap::round) {
+      line(x0, y0, x1, y1, color);
+      return;
+    }
+    point_fx pts[max_stroke_points];
+    usize n = stroke_outline(point_fx::from({x0, y0}), point_fx::from({x1, y1}),
+                             thickness, cap, pts);
+    fill_polygon(std::span<const point_fx>(pts, n), color);
+  }
+
   void hline(i16 x, i16 y, i16 length, u16 color) {
-    if (y < 0 || y >= height()) return;
-    i16 x_start = std::max<i16>(0, x);
-    i16 x_end = std::min<i16>(width() - 1, x + length - 1);
-    if (x_start > x_end) return;
+    jpico::rect c = clip();
+    point o = origin();
+    y += o.y;
+    if (y < c.y() || y >= c.bottom()) return;
+    i16 x_start = std::max<i16>(c.x(), x + o.x);
+    i16 x_end = std::min<i16>(c.right(), x + o.x + length);
+    if (x_start >= x_end) return;
 
-    if (framebuffer_) {
-      for (i16 i = x_start; i <= x_end; ++i) {
-        framebuffer_[y * width() + i] = color;
-      }
-      framebuffer_dirty_ = true;
-    } else {
-      for (i16 i = x_start; i <= x_end; ++i) {
-        display_.pixel(static_cast<u16>(i), static_cast<u16>(y), color);
-      }
-    }
+    span(y, x_start, x_end, color);
   }
 
   void vline(i16 x, i16 y, i16 h, u16 color) {
-    if (x < 0 || x >= width()) return;
-    i16 y_start = std::max<i16>(0, y);
-    i16 y_end = std::min<i16>(height() - 1, y + h - 1);
+    jpico::rect c = clip();
+    point o = origin();
+    x += o.x;
+    if (x < c.x() || x >= c.right()) return;
+    i16 y_start = std::max<i16>(c.y(), y + o.y);
+    i16 y_end = std::min<i16>(c.bottom() - 1, y + o.y + h - 1);
     if (y_start > y_end) return;
 
     if (framebuffer_) {
-      for (i16 i = y_start; i <= y_end; ++i) {
-        framebuffer_[i * width() + x] = color;
-      }
+      for (i16 i = y_start; i <= y_end; ++i) fb_put(x, i, color);
       framebuffer_dirty_ = true;
     } else {
-      for (i16 i = y_start; i <= y_end; ++i) {
-        display_.pixel(static_cast<u16>(x), static_cast<u16>(i), color);
+      u16 buf[line_chunk];
+      std::fill_n(buf, line_chunk, color);
+      for (i16 i = y_start; i <= y_end;) {
+        i16 p = panel_row(i);
+        u16 n = std::min<i16>(std::min<i16>(line_chunk, y_end - i + 1),
+                              height() - p);
+        send_blit(static_cast<u16>(x), static_cast<u16>(p), 1, n, buf);
+        i += n;
       }
     }
   }
 
   void rect(i16 x, i16 y, i16 w, i16 h, u16 color) {
+    if (!visible(x, y, x + w - 1, y + h - 1)) return;
     hline(x, y, w, color);
     hline(x, y + h - 1, w, color);
     vline(x, y, h, color);
@@ -145,32 +577,27 @@ class canvas {
   }
 
   void fill_rect(i16 x, i16 y, i16 w, i16 h, u16 color) {
-    i16 x_start = std::max<i16>(0, x);
-    i16 y_start = std::max<i16>(0, y);
-    i16 x_end = std::min<i16>(width() - 1, x + w - 1);
-    i16 y_end = std::min<i16>(height() - 1, y + h - 1);
-    if (x_start > x_end || y_start > y_end) return;
+    jpico::rect c = clip();
+    point o = origin();
+    i16 x_start = std::max<i16>(c.x(), x + o.x);
+    i16 y_start = std::max<i16>(c.y(), y + o.y);
+    i16 x_end = std::min<i16>(c.right(), x + o.x + w);
+    i16 y_end = std::min<i16>(c.bottom(), y + o.y + h);
+    if (x_start >= x_end || y_start >= y_end) return;
 
-    if (framebuffer_) {
-      for (i16 j = y_start; j <= y_end; ++j)
-        for (i16 i = x_start; i <= x_end; ++i)
-          framebuffer_[j * width() + i] = color;
-      framebuffer_dirty_ = true;
-    } else {
-      for (i16 j = y_start; j <= y_end; ++j)
-        for (i16 i = x_start; i <= x_end; ++i)
-          display_.pixel(static_cast<u16>(i), static_cast<u16>(j), color);
-    }
+    for (i16 j = y_start; j < y_end; ++j) span(j, x_start, x_end, color);
   }
 
   void circle(i16 x0, i16 y0, i16 r, u16 color) {
+    if (!visible(x0 - r, y0 - r, x0 + r, y0 + r)) return;
     i16 f = 1 - r, ddF_x = 1, ddF_y = -2 * r;
     i16 x = 0, y = r;
+    pixel_batch b{*this, color};
 
-    pixel(x0, y0 + r, color);
-    pixel(x0, y0 - r, color);
-    pixel(x0 + r, y0, color);
-    pixel(x0 - r, y0, color);
+    b.put(x0, y0 + r);
+    b.put(x0, y0 - r);
+    b.put(x0 + r, y0);
+    b.put(x0 - r, y0);
 
     while (x < y) {
       if (f >= 0) {
@@ -181,98 +608,237 @@ class canvas {
       x++;
       ddF_x += 2;
       f += ddF_x;
-      pixel(x0 + x, y0 + y, color);
-      pixel(x0 - x, y0 + y, color);
-      pixel(x0 + x, y0 - y, color);
-      pixel(x0 - x, y0 - y, color);
-      pixel(x0 + y, y0 + x, color);
-      pixel(x0 - y, y0 + x, color);
-      pixel(x0 + y, y0 - x, color);
-      pixel(x0 - y, y0 - x, color);
+      b.put(x0 + x, y0 + y);
+      b.put(x0 - x, y0 + y);
+      b.put(x0 + x, y0 - y);
+      b.put(x0 - x, y0 - y);
+      b.put(x0 + y, y0 + x);
+      b.put(x0 - y, y0 + x);
+      b.put(x0 + y, y0 - x);
+      b.put(x0 - y, y0 - x);
     }
   }
 
   void fill_circle(i16 x0, i16 y0, i16 r, u16 color) {
-    vline(x0, y0 - r, 2 * r + 1, color);
-    i16 f = 1 - r, ddF_x = 1, ddF_y = -2 * r;
-    i16 x = 0, y = r;
+    if (r < 0) return;
+    fill_arc(x0, y0, r, 0, 0, 360, color);
+  }
 
-    while (x < y) {
-      if (f >= 0) {
-        y--;
-        ddF_y += 2;
-        f += ddF_y;
+  // ring segment between two radii (inclusive), clockwise from start to end
+  // in degrees with 0 at 3 o'clock. r_inner 0 gives a pie slice.
+  void fill_arc(i16 cx, i16 cy, u16 r_outer, u16 r_inner, i16 start, i16 end,
+                u16 color) {
+    if (!visible(cx - r_outer, cy - r_outer, cx + r_outer, cy + r_outer))
+      return;
+    rasterize_arc(cx, cy, r_outer, r_inner, start, end, clip_rect(),
+                  spans(color));
+  }
+
+  void fill_pie(i16 cx, i16 cy, u16 r, i16 start, i16 end, u16 color) {
+    fill_arc(cx, cy, r, 0, start, end, color);
+  }
+
+  // arc stroke `thickness` pixels wide, growing inwards from radius r
+  void arc(i16 cx, i16 cy, u16 r, i16 start, i16 end, u16 color,
+           u16 thickness = 1) {
+    if (thickness == 0) return;
+    u16 inner = thickness > r ? 0 : static_cast<u16>(r - thickness + 1);
+    fill_arc(cx, cy, r, inner, start, end, color);
+  }
+
+  void fill_round_rect(i16 x, i16 y, i16 w, i16 h, u16 r, u16 color) {
+    if (w <= 0 || h <= 0) return;
+    rasterize_round_rect({{x, y}, {static_cast<u16>(w), static_cast<u16>(h)}},
+                         r, 0, clip_rect(), spans(color));
+  }
+
+  void round_rect(i16 x, i16 y, i16 w, i16 h, u16 r, u16 color,
+                  u16 thickness = 1) {
+    if (w <= 0 || h <= 0 || thickness == 0) return;
+    rasterize_round_rect({{x, y}, {static_cast<u16>(w), static_cast<u16>(h)}},
+                         r, thickness, clip_rect(), spans(color));
+  }
+
+  void fill_triangle(i16 x0, i16 y0, i16 x1, i16 y1, i16 x2, i16 y2,
+                     u16 color) {
+    point_fx pts[3] = {point_fx::from({x0, y0}), point_fx::from({x1, y1}),
+                       point_fx::from({x2, y2})};
+    fill_polygon(std::span<const point_fx>(pts), color);
+  }
+
+  // vertices sit on pixel centers. up to max_polygon_points vertices.
+  void fill_polygon(std::span<const point> pts, u16 color,
+                    fill_rule rule = fill_rule::non_zero) {
+    fill_vertices(pts, color, rule);
+  }
+
+  // subpixel version, vertices in 1/16 pixel units
+  void fill_polygon(std::span<const point_fx> pts, u16 color,
+                    fill_rule rule = fill_rule::non_zero) {
+    fill_vertices(pts, color, rule);
+  }
+
+  void draw_image(i16 x, i16 y, u16 img_w, u16 img_h, const u16* data) {
+    if (!img_w || !img_h) return;
+    // wholly visible: one blit in direct mode instead of one per row
+    jpico::rect c = clip();
+    i32 left = x + origin().x, top = y + origin().y;
+    if (left >= c.x() && top >= c.y() && left + img_w <= c.right() &&
+        top + img_h <= c.bottom()) {
+      put_block(static_cast<i16>(top), static_cast<i16>(left), img_w, img_h,
+                data, nullptr);
+      return;
+    }
+    image_rows(x, y, img_w, img_h, [&](i16 dy, i16 dx, u16 sx, u16 sy, i16 n) {
+      put_row(dy, dx, &data[sy * img_w + sx], n);
+    });
+  }
+
+  void draw_image(i16 x, i16 y, const image& img) {
+    draw_image(x, y, img, 255);
+  }
+
+  // `alpha` scales the whole image on top of its own alpha channel.
+  // blending reads the destination, so it needs an rgb565 framebuffer or
+  // set_readback(); elsewhere pixels at least half opaque are drawn and
+  // the rest skipped.
+  void draw_image(i16 x, i16 y, const image& img, u8 alpha) {
+    if (alpha == 0) return;
+    if (!img.alpha && alpha == 255) {
+      if (img.use_color_key) {
+        draw_image_keyed(x, y, img);
+      } else {
+        draw_image(x, y, img.w, img.h, img.data);
       }
-      x++;
-      ddF_x += 2;
-      f += ddF_x;
-      vline(x0 + x, y0 - y, 2 * y + 1, color);
-      vline(x0 - x, y0 - y, 2 * y + 1, color);
-      vline(x0 + y, y0 - x, 2 * x + 1, color);
-      vline(x0 - y, y0 - x, 2 * x + 1, color);
+      return;
     }
+    image_rows(x, y, img.w, img.h, [&](i16 dy, i16 dx, u16 sx, u16 sy, i16 n) {
+      blend_row(dy, dx, img, sx, sy, n, alpha);
+    });
   }
 
-  void draw_image(i16 x, i16 y, u16 img_w, u16 img_h, const u16* data) {
-    i16 sx = 0, sy = 0;
-    i16 dx = x, dy = y;
-    i16 w = static_cast<i16>(img_w);
-    i16 h = static_cast<i16>(img_h);
-
-    if (dx < 0) {
-      sx = -dx;
-      w += dx;
-      dx = 0;
-    }
-    if (dy < 0) {
-      sy = -dy;
-      h += dy;
-      dy = 0;
-    }
-    if (dx + w > width()) w = width() - dx;
-    if (dy + h > height()) h = height() - dy;
-    if (w <= 0 || h <= 0) return;
+  void draw_image(i16 x, i16 y, const palette_image& img) {
+    if (!visible(x, y, x + img.w - 1, y + img.h - 1)) return;
+    jpico::rect c = clip_rect();
+    u16 buf[line_chunk];
+    u8 idx[line_chunk];
+    for (u16 row = 0; row < img.h; ++row) {
+      i16 sy = y + row;
+      if (sy < c.y() || sy >= c.bottom()) continue;
+      for (u16 col = 0; col < img.w; col += line_chunk) {
+        u16 n = std::min<u16>(line_chunk, img.w - col);
+        // indexed framebuffers take the indices as they are
+        bool expand = !is_indexed(format());
+        for (u16 i = 0; i < n; ++i) {
+          idx[i] = img.index(col + i, row);
+          buf[i] = expand ? img.palette[idx[i]] : idx[i];
+        }
+        if (!img.use_color_key) {
+          draw_image(x + col, sy, n, 1, buf);
+          continue;
+        }
+        for (u16 i = 0; i < n;) {
+          while (i < n && idx[i] == img.color_key) ++i;
+          u16 s = i;
+          while (i < n && idx[i] != img.color_key) ++i;
+          if (i > s) draw_image(x + col + s, sy, i - s, 1, &buf[s]);
+        }
+      }
+    }
+  }
 
-    if (framebuffer_) {
-      for (i16 row = 0; row < h; ++row) {
-        const u16* src = &data[(sy + row) * img_w + sx];
-        u16* dst = &framebuffer_[(dy + row) * width() + dx];
-        std::memcpy(dst, src, static_cast<usize>(w) * sizeof(u16));
+  // streams the image op by op. clipped columns and rows are skipped at
+  // the op level, skip ops leave the background untouched, and opaque
+  // pixels are gathered into a small line buffer and blitted per segment.
+  void draw_image(i16 x, i16 y, const rle_image& img) {
+    jpico::rect c = clip_rect();
+    i16 c0 = std::max<i16>(0, c.x() - x);
+    i16 c1 = std::min<i16>(img.w, c.right() - x);
+    i16 r1 = std::min<i16>(img.h, c.bottom() - y);
+    if (c0 >= c1 || r1 <= 0 || y + img.h <= c.y()) return;
+
+    u16 buf[line_chunk];
+    detail::rle_reader rd(img.data);
+    for (i16 row = 0; row < r1; ++row) {
+      i16 sy = y + row;
+      if (sy < c.y()) {
+        rd.skip(img.w);
+        continue;
       }
-      framebuffer_dirty_ = true;
-    } else {
-      for (i16 row = 0; row < h; ++row) {
-        display_.blit(static_cast<u16>(dx), static_cast<u16>(dy + row),
-                      static_cast<u16>(w), 1, &data[(sy + row) * img_w + sx]);
+
+      u16 len = 0;
+      i16 seg = 0;
+      auto flush_segment = [&] {
+        if (len) draw_image(x + seg, sy, len, 1, buf);
+        len = 0;
+      };
+
+      for (i16 col = 0; col < static_cast<i16>(img.w);) {
+        i16 n = rd.fetch();
+        if (col + n <= c0 || col >= c1) {
+          rd.skip(n);
+          col += n;
+          continue;
+        }
+        if (col < c0) {
+          rd.skip(c0 - col);
+          col = c0;
+          continue;
+        }
+        n = std::min<i16>(n, c1 - col);
+        if (rd.transparent()) {
+          flush_segment();
+          rd.skip(n);
+          col += n;
+          continue;
+        }
+        if (!len) seg = col;
+        n = std::min<i16>(n, line_chunk - len);
+        rd.read(&buf[len], n);
+        len += n;
+        col += n;
+        if (len == line_chunk) flush_segment();
       }
+      flush_segment();
     }
   }
 
-  void draw_image(i16 x, i16 y, const image& img) {
-    if (img.use_color_key) {
-      draw_image_keyed(x, y, img);
-    } else {
-      draw_image(x, y, img.w, img.h, img.data);
+  // rotated or mirrored blit with the top-left corner of the result at
+  // (x, y); transposing orientations swap its width and height. the
+  // source is walked in small square tiles so reads stay within a few
+  // rows and each tile goes out as one block.
+  void draw_image(i16 x, i16 y, u16 img_w, u16 img_h, const u16* data,
+                  transform t) {
+    draw_transformed(x, y, img_w, img_h, data, t, nullptr);
+  }
+
+  // color keys are honored; the alpha channel is not used
+  void draw_image(i16 x, i16 y, const image& img, transform t) {
+    if (t == transform::none) {
+      draw_image(x, y, img);
+      return;
     }
+    draw_transformed(x, y, img.w, img.h, img.data, t,
+                     img.use_color_key ? &img.color_key : nullptr);
   }
 
+  // scales img_w x img_h source pixels to dst_w x dst_h at (x, y). source
+  // positions are stepped in 16.16 fixed point, the column lookups are
+  // built once per call and whole rows go out at a time. bilinear blends
+  // the four nearest source pixels; indexed framebuffers always sample
+  // nearest.
   void draw_image_scaled(i16 x, i16 y, u16 dst_w, u16 dst_h, u16 img_w,
-                         u16 img_h, const u16* data) {
-    for (i16 dy = 0; dy < static_cast<i16>(dst_h); ++dy) {
-      i16 screen_y = y + dy;
-      if (screen_y < 0 || screen_y >= height()) continue;
-      u16 src_y = static_cast<u16>(static_cast<u32>(dy) * img_h / dst_h);
-      for (i16 dx = 0; dx < static_cast<i16>(dst_w); ++dx) {
-        i16 screen_x = x + dx;
-        if (screen_x < 0 || screen_x >= width()) continue;
-        u16 src_x = static_cast<u16>(static_cast<u32>(dx) * img_w / dst_w);
-        pixel(screen_x, screen_y, data[src_y * img_w + src_x]);
-      }
-    }
+                         u16 img_h, const u16* data,
+                         scale_filter filter = scale_filter::nearest) {
+    draw_scaled(x, y, dst_w, dst_h, img_w, img_h, data, filter, nullptr);
   }
 
-  void draw_image_scaled(i16 x, i16 y, u16 dst_w, u16 dst_h, const image& img) {
-    draw_image_scaled(x, y, dst_w, dst_h, img.w, img.h, img.data);
+  // color keyed images are sampled nearest and key pixels are skipped.
+  // the alpha channel is not used.
+  void draw_image_scaled(i16 x, i16 y, u16 dst_w, u16 dst_h, const image& img,
+                         scale_filter filter = scale_filter::nearest) {
+    draw_scaled(x, y, dst_w, dst_h, img.w, img.h, img.data, filter,
+                img.use_color_key ? &img.color_key : nullptr);
   }
 
   void set_cursor(i16 x, i16 y) {
@@ -293,33 +859,98 @@ class canvas {
   void set_font(const font* f) { font_ = f; }
 
   void draw_char(i16 x, i16 y, char c, u16 fg, u16 bg, u8 sx = 1, u8 sy = 1) {
+    draw_glyph(x, y, static_cast<u8>(c), fg, bg, sx, sy);
+  }
+
+  // one codepoint. the builtin font only has printable ascii.
+  void draw_glyph(i16 x, i16 y, u32 cp, u16 fg, u16 bg, u8 sx = 1,
+                  u8 sy = 1) {
     if (font_) {
-      draw_char_font(x, y, c, fg, sx, sy);
-    } else {
-      draw_char_builtin(x, y, c, fg, bg, sx, sy);
+      draw_char_font(x, y, cp, fg, sx, sy);
+    } else if (cp < 0x80) {
+      draw_char_builtin(x, y, static_cast<char>(cp), fg, bg, sx, sy);
     }
   }
 
-  void write_char(char c) {
-    if (c == '\n') {
-      cursor_x_ = 0;
-      cursor_y_ += (font_ ? font_->y_advance : 8) * text_size_y_;
-    } else if (c == '\r') {
-      cursor_x_ = 0;
+  // lines start and wrap at the edges of the active clip
+  void write_char(char c) { write_codepoint(static_cast<u8>(c)); }
+
+  void write_codepoint(u32 cp) {
+    jpico::rect area = clip_rect();
+    text_style st = current_text_style();
+    if (cp == '\n') {
+      cursor_x_ = area.x();
+      cursor_y_ += st.line_height();
+    } else if (cp == '\r') {
+      cursor_x_ = area.x();
     } else {
-      u8 cw = font_ ? font_->glyphs[c - font_->first].x_advance : 6;
-      if (text_wrap_ && (cursor_x_ + cw * text_size_x_ > width())) {
-        cursor_x_ = 0;
-        cursor_y_ += (font_ ? font_->y_advance : 8) * text_size_y_;
+      u16 cw = st.advance(cp);
+      if (text_wrap_ && cursor_x_ > area.x() &&
+          cursor_x_ + cw > area.right()) {
+        cursor_x_ = area.x();
+        cursor_y_ += st.line_height();
       }
-      draw_char(cursor_x_, cursor_y_, c, text_color_, text_bg_color_,
-                text_size_x_, text_size_y_);
-      cursor_x_ += cw * text_size_x_;
+      draw_glyph(cursor_x_, cursor_y_, cp, text_color_, text_bg_color_,
+                 text_size_x_, text_size_y_);
+      cursor_x_ += cw;
     }
   }
 
+  // utf-8
   void print(const char* str) {
-    while (*str) write_char(*str++);
+    while (*str) write_codepoint(utf8_next(str));
+  }
+
+  // formatted straight onto the canvas, no buffer:
+  //   canvas.print("{:>5.1} C", fixed{temp, 8});
+  template <typename... Args>
+  void print(format_string<Args...> fmt, const Args&... args) {
+    text_sink out{*this};
+    format_to(out, fmt, args...);
+  }
+
+  // font and size as set on this canvas, for measuring and layout
+  text_style current_text_style() const {
+    return {font_, text_size_x_, text_size_y_};
+  }
+
+  // extent print() would cover, without wrapping and without drawing
+  size measure_text(const char* str) const {
+    return measure(current_text_style(), str);
+  }
+
+  // word-wrapped text inside box, aligned within it, clipped to it. uses
+  // the current font, size and colors; the cursor is left alone.
+  void draw_text(jpico::rect box, const char* str,
+                 text_align align = text_align::left,
+                 text_valign valign = text_valign::top) {
+    text_style st = current_text_style();
+    u16 lines = for_each_line(st, str, box.width(),
+                              [](const wrapped_line&) { return true; });
+    i16 y = text_top(box, static_cast<u16>(lines * st.line_height()), valign);
+    if (!push_clip(box)) return;
+    for_each_line(st, str, box.width(), [&](const wrapped_line& l) {
+      draw_line(st, box, y, l.begin, l.end, l.width, align);
+      y = static_cast<i16>(y + st.line_height());
+      return true;
+    });
+    pop_clip();
+  }
+
+  // a layout made for this canvas's font and size, e.g. kept by a widget
+  template <usize N>
+  void draw_text(jpico::rect box, const text_layout<N>& layout,
+                 text_align align = text_align::left,
+                 text_valign valign = text_valign::top) {
+    const text_style& st = layout.style();
+    i16 y = text_top(box, layout.extent().h, valign);
+    if (!push_clip(box)) return;
+    for (const text_line& l : layout.lines()) {
+      const char* begin = layout.text() + l.offset;
+      draw_line(st, box, y, begin, begin + l.length, l.width, align);
+      y = static_cast<i16>(y + st.line_height());
+    }
+    pop_clip();
   }
 
   void printf(const char* format, ...) {
@@ -331,28 +962,506 @@ class canvas {
     print(buffer);
   }
 
+  // scrolling by the height or more leaves only blank rows
   void scroll_up(i16 pixels) {
-    if (!framebuffer_) return;
-    u16 w = width(), h = height();
-
-    for (i16 y = 0; y < h - pixels; y++) {
-      std::memcpy(&framebuffer_[y * w], &framebuffer_[(y + pixels) * w],
-                  w * sizeof(u16));
-    }
-    for (i16 y = h - pixels; y < h; y++) {
-      for (i16 x = 0; x < w; x++) {
-        framebuffer_[y * w + x] = clear_color_;
+    i16 h = static_cast<i16>(height());
+    pixels = std::min(pixels, h);
+    if (pixels <= 0) return;
+    if constexpr (scrollable_display<D>) {
+      if (hw_scroll_) {
+        hw_scroll_up(pixels);
+        return;
       }
     }
+    if (!framebuffer_) return;
+    u16 w = width();
+
+    std::memmove(row_bytes(0), row_bytes(pixels),
+                 static_cast<usize>(h - pixels) * stride());
+    for (i16 y = h - pixels; y < h; y++) fb_span(y, 0, w, clear_color_);
     framebuffer_dirty_ = true;
   }
 
-  u16 width() const { return display_.width(); }
-  u16 height() const { return display_.height(); }
+  constexpr u16 width() const {
+    if constexpr (fixed_size) {
+      return Storage::width;
+    } else {
+      return display_.width();
+    }
+  }
+
+  constexpr u16 height() const {
+    if constexpr (fixed_size) {
+      return Storage::height;
+    } else {
+      return display_.height();
+    }
+  }
   i16 cursor_x() const { return cursor_x_; }
   i16 cursor_y() const { return cursor_y_; }
+  u16 text_color() const { return text_color_; }
+  u16 text_background() const { return text_bg_color_; }
+  const font* current_font() const { return font_; }
 
  private:
+  static constexpr u16 line_chunk = 64;
+  static constexpr i16 tile_size = 16;  // rotated blits, 512 bytes of stack
+  static constexpr i16 scan_band = 16;  // rows per blit of a bottom-up flush
+
+  struct clip_state {
+    jpico::rect clip;  // screen coordinates
+    point origin;
+  };
+
+  constexpr usize stride() const {
+    if constexpr (fixed_size) {
+      return Storage::stride;
+    } else {
+      return stride_;
+    }
+  }
+
+  jpico::rect screen_rect() const { return {{0, 0}, {width(), height()}}; }
+
+  // active clip in screen coordinates
+  jpico::rect clip() const {
+    return clip_depth_ ? clip_stack_[clip_depth_ - 1].clip : screen_rect();
+  }
+
+  bool push_clip_state(jpico::rect r, point shift) {
+    if (clip_depth_ == max_clip_depth) return false;
+    point o = origin();
+    jpico::rect c = jpico::rect{r.origin + o, r.dims}.intersection(clip());
+    clip_stack_[clip_depth_++] = {c, o + shift};
+    return true;
+  }
+
+  // up-front rejection: false when the inclusive box [x0, x1] x [y0, y1],
+  // in current coordinates, misses the active clip
+  bool visible(i32 x0, i32 y0, i32 x1, i32 y1) const {
+    jpico::rect c = clip_rect();
+    return !c.empty() && x0 < c.right() && x1 >= c.x() && y0 < c.bottom() &&
+           y1 >= c.y();
+  }
+
+  // clips a w x h block at (x, y), in current coordinates, to the active
+  // clip and calls row(screen_y, screen_x, src_x, src_y, n) per visible row
+  template <typename Row>
+  void image_rows(i16 x, i16 y, u16 w, u16 h, Row&& row) {
+    jpico::rect c = clip();
+    point o = origin();
+    i32 left = x + o.x, top = y + o.y;
+    i32 x0 = std::max<i32>(left, c.x());
+    i32 x1 = std::min<i32>(left + w, c.right());
+    i32 y0 = std::max<i32>(top, c.y());
+    i32 y1 = std::min<i32>(top + h, c.bottom());
+    if (x0 >= x1 || y0 >= y1) return;
+    for (i32 sy = y0; sy < y1; ++sy) {
+      row(static_cast<i16>(sy), static_cast<i16>(x0),
+          static_cast<u16>(x0 - left), static_cast<u16>(sy - top),
+          static_cast<i16>(x1 - x0));
+    }
+  }
+
+  // n source pixels onto screen row y at x, already clipped
+  void put_row(i16 y, i16 x, const u16* src, i16 n) {
+    if (framebuffer_) {
+      fb_copy(y, x, src, n);
+      framebuffer_dirty_ = true;
+    } else {
+      send_blit(static_cast<u16>(x), static_cast<u16>(panel_row(y)),
+                static_cast<u16>(n), 1, src);
+    }
+  }
+
+  // w x h packed pixels onto the screen at (x, y), already clipped. key,
+  // when set, is skipped.
+  void put_block(i16 y, i16 x, i16 w, i16 h, const u16* src, const u16* key) {
+    if (!key && !framebuffer_ && panel_row(y) + h <= height()) {
+      send_blit(static_cast<u16>(x), static_cast<u16>(panel_row(y)),
+                static_cast<u16>(w), static_cast<u16>(h), src);
+      return;
+    }
+    for (i16 r = 0; r < h; ++r, src += w) {
+      if (key) {
+        put_row_keyed(y + r, x, src, w, *key);
+      } else {
+        put_row(y + r, x, src, w);
+      }
+    }
+  }
+
+  // like put_row, copying only the runs between pixels equal to key
+  void put_row_keyed(i16 y, i16 x, const u16* src, i16 n, u16 key) {
+    for (i16 i = 0; i < n;) {
+      while (i < n && src[i] == key) ++i;
+      i16 s = i;
+      while (i < n && src[i] != key) ++i;
+      if (i > s) put_row(y, x + s, src + s, i - s);
+    }
+  }
+
+  template <typename P>
+  void fill_vertices(std::span<const P> pts, u16 color, fill_rule rule) {
+    if (pts.empty()) return;
+    point_fx lo = to_fx(pts[0]), hi = lo;
+    for (const P& v : pts) {
+      point_fx p = to_fx(v);
+      lo = {std::min(lo.x, p.x), std::min(lo.y, p.y)};
+      hi = {std::max(hi.x, p.x), std::max(hi.y, p.y)};
+    }
+    if (!visible(lo.x >> 4, lo.y >> 4, hi.x >> 4, hi.y >> 4)) return;
+    rasterize_polygon(pts.data(), pts.size(), rule, clip_rect(),
+                      spans(color));
+  }
+
+  // span emitter for the rasterizers, which work in current coordinates
+  // against clip_rect()
+  auto spans(u16 color) {
+    return [this, o = origin(), color](i16 y, i16 x0, i16 x1) {
+      span(y + o.y, x0 + o.x, x1 + o.x, color);
+    };
+  }
+
+  // clipped span [x0, x1) on row y, to the framebuffer or the display
+  void span(i16 y, i16 x0, i16 x1, u16 color) {
+    if (framebuffer_) {
+      fb_span(y, x0, x1, color);
+      framebuffer_dirty_ = true;
+      return;
+    }
+    u16 buf[line_chunk];
+    std::fill_n(buf, std::min<i16>(line_chunk, x1 - x0), color);
+    u16 p = static_cast<u16>(panel_row(y));
+    for (i16 x = x0; x < x1; x += line_chunk) {
+      u16 n = std::min<u16>(line_chunk, x1 - x);
+      send_blit(static_cast<u16>(x), p, n, 1, buf);
+    }
+  }
+
+  // everything bound for the display goes through these so the frame
+  // stats see it
+  void send_blit(u16 x, u16 y, u16 w, u16 h, const u16* data) {
+    display_.blit(x, y, w, h, data);
+    count_blit(w, h);
+  }
+
+  void send_blit(u16 x, u16 y, u16 w, u16 h, const u16* data, usize stride) {
+    display_.blit(x, y, w, h, data, stride);
+    count_blit(w, h);
+  }
+
+  void send_pixel(u16 x, u16 y, u16 color) {
+    display_.pixel(x, y, color);
+    if constexpr (stats_enabled) ++frame_.pixel_calls;
+  }
+
+  template <typename Points>
+  void send_pixels(Points pts, u16 color) {
+    display_.pixels(pts, color);
+    if constexpr (stats_enabled) ++frame_.pixel_calls;
+  }
+
+  template <typename Points>
+  void send_pixels(Points pts) {
+    display_.pixels(pts);
+    if constexpr (stats_enabled) ++frame_.pixel_calls;
+  }
+
+  // single-color pixels of one primitive, in current coordinates. on a
+  // batch_display in direct mode they are clipped into a chunk that goes
+  // out when full and when the batch ends; otherwise each is a pixel().
+  class pixel_batch {
+   public:
+    pixel_batch(canvas& c, u16 color) : c_{c}, color_{color} {}
+    ~pixel_batch() { submit(); }
+
+    pixel_batch(const pixel_batch&) = delete;
+    pixel_batch& operator=(const pixel_batch&) = delete;
+
+    void put(i16 x, i16 y) {
+      if constexpr (batch_display<D>) {
+        if (!c_.framebuffer_) {
+          point p = point{x, y} + c_.origin();
+          if (!c_.clip().contains(p)) return;
+          pts_[n_++] = {p.x, c_.panel_row(p.y)};
+          if (n_ == line_chunk) submit();
+          return;
+        }
+      }
+      c_.pixel(x, y, color_);
+    }
+
+    void submit() {
+      if constexpr (batch_display<D>) {
+        if (n_) c_.send_pixels(std::span<const point>(pts_, n_), color_);
+        n_ = 0;
+      }
+    }
+
+   private:
+    canvas& c_;
+    u16 color_;
+    point pts_[batch_display<D> ? line_chunk : 1];
+    u16 n_ = 0;
+  };
+
+  void count_blit(u16 w, u16 h) {
+    if constexpr (stats_enabled) {
+      ++frame_.blits;
+      frame_.blit_pixels += u32{w} * h;
+    }
+  }
+
+  void flushed_since(u32 t0) {
+    if constexpr (stats_enabled) frame_.flush_us += stats_now_us() - t0;
+  }
+
+  // canvas row -> row in panel/framebuffer order under hardware scroll
+  i16 panel_row(i16 y) const {
+    i16 p = y + scroll_offset_;
+    return p >= height() ? p - height() : p;
+  }
+
+  u8* row_bytes(i16 y) {
+    return reinterpret_cast<u8*>(framebuffer_) + panel_row(y) * stride();
+  }
+
+  // hash every tile and send the runs of changed tiles in each tile row
+  void flush_tiles() {
+    tile_stats_ = {};
+    const u8* base = reinterpret_cast<const u8*>(framebuffer_);
+    for (u16 ty = 0; ty < tile_rows_; ++ty) {
+      i16 p = static_cast<i16>(ty * tile_);
+      i16 h = std::min<i16>(tile_, height() - p);
+      const u8* row = base + p * stride();
+      u32* hashes = &tile_hashes_[ty * tile_cols_];
+
+      i16 run = -1;  // first tile of the pending run of changed tiles
+      for (u16 tx = 0; tx <= tile_cols_; ++tx) {
+        bool changed = false;
+        if (tx < tile_cols_) {
+          i16 x0 = static_cast<i16>(tx * tile_);
+          i16 x1 = std::min<i16>(width(), x0 + tile_);
+          usize b0 = byte_offset(x0), b1 = byte_offset(x1);
+          u32 v = tile_hash_(tile_ctx_, row + b0, stride(), b1 - b0,
+                             static_cast<u16>(h));
+          changed = !tiles_valid_ || hashes[tx] != v;
+          hashes[tx] = v;
+          ++(changed ? tile_stats_.sent : tile_stats_.skipped);
+        }
+        if (changed && run < 0) run = static_cast<i16>(tx);
+        if (!changed && run >= 0) {
+          i16 x0 = static_cast<i16>(run * tile_);
+          i16 x1 = std::min<i16>(width(), tx * tile_);
+          blit_block(x0, p, x1 - x0, h);
+          ++tile_stats_.blits;
+          run = -1;
+        }
+      }
+    }
+    tiles_valid_ = true;
+  }
+
+  // framebuffer bytes before column x; rounds up mid-byte in indexed4,
+  // which only the row end can be
+  usize byte_offset(i16 x) const {
+    switch (format()) {
+      case pixel_format::rgb565:
+      case pixel_format::rgb565_be:
+        return static_cast<usize>(x) * 2;
+      case pixel_format::indexed8:
+        return static_cast<usize>(x);
+      case pixel_format::indexed4:
+        return (static_cast<usize>(x) + 1) / 2;
+    }
+    return 0;
+  }
+
+  // send a w x h block of the framebuffer at panel row p
+  void blit_block(i16 x, i16 p, i16 w, i16 h) {
+    if (w == width()) {
+      blit_rows(p, h);
+      return;
+    }
+    if constexpr (stats_enabled) frame_.dirty_area += u32(w) * u32(h);
+    u8* base = reinterpret_cast<u8*>(framebuffer_);
+    if (format() == pixel_format::rgb565_be) {
+      blit_be(x, p, w, h);
+      return;
+    }
+    if (format() == pixel_format::rgb565) {
+      const u16* src = reinterpret_cast<const u16*>(base + p * stride()) + x;
+      if constexpr (strided_display<D>) {
+        send_blit(static_cast<u16>(x), static_cast<u16>(p),
+                  static_cast<u16>(w), static_cast<u16>(h), src, width());
+      } else {
+        for (i16 r = 0; r < h; ++r, src += width()) {
+          send_blit(static_cast<u16>(x), static_cast<u16>(p + r),
+                    static_cast<u16>(w), 1, src);
+        }
+      }
+      return;
+    }
+    for (i16 y = p; y < p + h; ++y) {
+      expand_row(base + y * stride(), line_);
+      send_blit(static_cast<u16>(x), static_cast<u16>(y),
+                static_cast<u16>(w), 1, line_ + x);
+    }
+  }
+
+  // send n framebuffer rows starting at panel row p
+  void blit_rows(i16 p, i16 n) {
+    if constexpr (stats_enabled) frame_.dirty_area += u32{width()} * u32(n);
+    u8* base = reinterpret_cast<u8*>(framebuffer_);
+    if (format() == pixel_format::rgb565_be) {
+      blit_be(0, p, static_cast<i16>(width()), n);
+      return;
+    }
+    if (format() == pixel_format::rgb565) {
+      send_blit(0, static_cast<u16>(p), width(), static_cast<u16>(n),
+                reinterpret_cast<const u16*>(base + p * stride()));
+      return;
+    }
+    for (i16 y = p; y < p + n; ++y) {
+      expand_row(base + y * stride(), line_);
+      send_blit(0, static_cast<u16>(y), width(), 1, line_);
+    }
+  }
+
+  // rgb565_be block at panel row p: as it is to a display that takes wire
+  // order, otherwise swapped back a chunk at a time
+  void blit_be(i16 x, i16 p, i16 w, i16 h) {
+    const u16* src = framebuffer_ + static_cast<usize>(p) * width() + x;
+    if constexpr (be_display<D>) {
+      display_.blit_be(static_cast<u16>(x), static_cast<u16>(p),
+                       static_cast<u16>(w), static_cast<u16>(h), src, width());
+      count_blit(static_cast<u16>(w), static_cast<u16>(h));
+    } else {
+      u16 buf[line_chunk];
+      for (i16 r = 0; r < h; ++r, src += width()) {
+        for (i16 c = 0; c < w; c += line_chunk) {
+          i16 n = std::min<i16>(line_chunk, w - c);
+          for (i16 i = 0; i < n; ++i) buf[i] = std::byteswap(src[c + i]);
+          send_blit(static_cast<u16>(x + c), static_cast<u16>(p + r),
+                    static_cast<u16>(n), 1, buf);
+        }
+      }
+    }
+  }
+
+  // pixels in [1, height()]
+  void hw_scroll_up(i16 pixels) {
+    i16 h = static_cast<i16>(height());
+
+    // the top rows are about to wrap around to the bottom: blank them first
+    bool dirty = framebuffer_dirty_;
+    for (i16 y = 0; y < pixels; ++y) span(y, 0, width(), clear_color_);
+    flush_rows(0, pixels);
+    framebuffer_dirty_ = dirty;
+
+    scroll_offset_ = static_cast<i16>((scroll_offset_ + pixels) % h);
+    display_.scroll_to(static_cast<u16>(scroll_offset_));
+  }
+
+  u16* row565(i16 y) { return reinterpret_cast<u16*>(row_bytes(y)); }
+
+  void fb_put(i16 x, i16 y, u16 color) {
+    switch (format()) {
+      case pixel_format::rgb565:
+        row565(y)[x] = color;
+        break;
+      case pixel_format::rgb565_be:
+        row565(y)[x] = std::byteswap(color);
+        break;
+      case pixel_format::indexed8:
+        row_bytes(y)[x] = static_cast<u8>(color);
+        break;
+      case pixel_format::indexed4: {
+        u8& b = row_bytes(y)[x / 2];
+        b = (x & 1) ? (b & 0xF0) | (color & 0x0F)
+                    : static_cast<u8>((b & 0x0F) | (color << 4));
+        break;
+      }
+    }
+  }
+
+  void fb_span(i16 y, i16 x0, i16 x1, u16 color) {
+    switch (format()) {
+      case pixel_format::rgb565:
+        std::fill(row565(y) + x0, row565(y) + x1, color);
+        break;
+      case pixel_format::rgb565_be:
+        std::fill(row565(y) + x0, row565(y) + x1, std::byteswap(color));
+        break;
+      case pixel_format::indexed8:
+        std::memset(row_bytes(y) + x0, static_cast<u8>(color), x1 - x0);
+        break;
+      case pixel_format::indexed4:
+        if (x0 & 1) fb_put(x0++, y, color);
+        if (x1 > x0 && (x1 & 1)) fb_put(--x1, y, color);
+        if (x1 > x0) {
+          u8 pair = static_cast<u8>((color & 0x0F) * 0x11);
+          std::memset(row_bytes(y) + x0 / 2, pair, (x1 - x0) / 2);
+        }
+        break;
+    }
+  }
+
+  void fb_copy(i16 y, i16 x, const u16* src, i16 n) {
+    if (format() == pixel_format::rgb565) {
+      std::memcpy(row565(y) + x, src, static_cast<usize>(n) * sizeof(u16));
+    } else if (format() == pixel_format::rgb565_be) {
+      u16* dst = row565(y) + x;
+      for (i16 i = 0; i < n; ++i) dst[i] = std::byteswap(src[i]);
+    } else if (format() == pixel_format::indexed8) {
+      u8* dst = row_bytes(y) + x;
+      for (i16 i = 0; i < n; ++i) dst[i] = static_cast<u8>(src[i]);
+    } else {
+      for (i16 i = 0; i < n; ++i) fb_put(x + i, y, src[i]);
+    }
+  }
+
+  // n pixels of screen row y from x as rgb565, from the framebuffer or
+  // read back off the panel
+  result<void> read_row(i16 y, i16 x, i16 n, u16* out) {
+    if (framebuffer_) {
+      if (is_indexed(format())) {
+        expand_row(row_bytes(y), line_);
+        std::copy_n(line_ + x, n, out);
+      } else {
+        const u16* src = row565(y) + x;
+        bool be = format() == pixel_format::rgb565_be;
+        for (i16 i = 0; i < n; ++i) {
+          out[i] = be ? std::byteswap(src[i]) : src[i];
+        }
+      }
+      return ok();
+    }
+    if constexpr (readable_display<D>) {
+      return display_.read_rect(static_cast<u16>(x),
+                                static_cast<u16>(panel_row(y)),
+                                static_cast<u16>(n), 1,
+                                std::span<u16>(out, static_cast<usize>(n)));
+    } else {
+      return fail(error_code::not_initialized, "no framebuffer to read");
+    }
+  }
+
+  // indexed row -> rgb565 through the palette
+  void expand_row(const u8* src, u16* out) {
+    u16 w = width();
+    if (format() == pixel_format::indexed8) {
+      for (u16 x = 0; x < w; ++x) out[x] = palette_[src[x]];
+    } else {
+      for (u16 x = 0; x + 1 < w; x += 2, ++src) {
+        out[x] = palette_[*src >> 4];
+        out[x + 1] = palette_[*src & 0x0F];
+      }
+      if (w & 1) out[w - 1] = palette_[*src >> 4];
+    }
+  }
+
   static constexpr u8 font5x7[] = {
       0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x5F, 0x00, 0x00, 0x00, 0x07,
       0x00, 0x07, 0x00, 0x14, 0x7F, 0x14, 0x7F, 0x14, 0x24, 0x2A, 0x7F, 0x2A,
@@ -396,19 +1505,78 @@ class canvas {
       0x08, 0x00, 0x08, 0x08, 0x2A, 0x1C, 0x08,
   };
 
+  // format sink that feeds write_codepoint, reassembling utf-8 sequences
+  // that arrive split across writes
+  struct text_sink {
+    canvas& c;
+    char seq[5] = {};
+    u8 have = 0;
+    u8 need = 0;
+
+    void write(const char* p, usize n) {
+      for (usize i = 0; i < n; ++i) put(static_cast<u8>(p[i]));
+    }
+
+    void put(u8 b) {
+      if (have && (b & 0xC0) != 0x80) {
+        c.write_codepoint(replacement_char);  // sequence cut short
+        have = 0;
+      }
+      if (!have) {
+        need = b >= 0xF0 ? 4 : b >= 0xE0 ? 3 : b >= 0xC0 ? 2 : 1;
+        if (need == 1) {
+          c.write_codepoint(b < 0x80 ? b : replacement_char);
+          return;
+        }
+      }
+      seq[have++] = static_cast<char>(b);
+      if (have < need) return;
+      seq[have] = '\0';
+      const char* q = seq;
+      c.write_codepoint(utf8_next(q));
+      have = 0;
+    }
+  };
+
+  i16 text_top(jpico::rect box, u16 h, text_valign valign) const {
+    i16 y = box.y();
+    if (valign == text_valign::middle)
+      y = static_cast<i16>(y + (box.height() - h) / 2);
+    if (valign == text_valign::bottom) y = static_cast<i16>(box.bottom() - h);
+    return y;
+  }
+
+  // one laid-out line with its top at y
+  void draw_line(const text_style& st, jpico::rect box, i16 y,
+                 const char* begin, const char* end, u16 w,
+                 text_align align) {
+    i16 x = box.x();
+    if (align == text_align::center)
+      x = static_cast<i16>(x + (box.width() - w) / 2);
+    if (align == text_align::right) x = static_cast<i16>(box.right() - w);
+    y = static_cast<i16>(y + st.ascent());
+    while (begin < end) {
+      u32 cp = utf8_next(begin);
+      draw_glyph(x, y, cp, text_color_, text_bg_color_, st.sx, st.sy);
+      x = static_cast<i16>(x + st.advance(cp));
+    }
+  }
+
   void draw_char_builtin(i16 x, i16 y, char c, u16 fg, u16 bg, u8 sx, u8 sy) {
     if (c < 32 || c > 126) return;
+    if (!visible(x, y, x + 5 * sx - 1, y + 8 * sy - 1)) return;
+    pixel_batch ink{*this, fg}, paper{*this, bg};
     for (u8 i = 0; i < 5; i++) {
       u8 line = font5x7[(c - 32) * 5 + i];
       for (u8 j = 0; j < 8; j++) {
         if (line & 0x01) {
           if (sx == 1 && sy == 1)
-            pixel(x + i, y + j, fg);
+            ink.put(x + i, y + j);
           else
             fill_rect(x + i * sx, y + j * sy, sx, sy, fg);
         } else if (bg != fg) {
           if (sx == 1 && sy == 1)
-            pixel(x + i, y + j, bg);
+            paper.put(x + i, y + j);
           else
             fill_rect(x + i * sx, y + j * sy, sx, sy, bg);
         }
@@ -417,19 +1585,23 @@ class canvas {
     }
   }
 
-  void draw_char_font(i16 x, i16 y, char c, u16 fg, u8 sx, u8 sy) {
-    if (c < font_->first || c > font_->last) return;
-    const glyph* g = &font_->glyphs[c - font_->first];
+  void draw_char_font(i16 x, i16 y, u32 cp, u16 fg, u8 sx, u8 sy) {
+    const glyph* g = find_glyph(*font_, cp);
+    if (!g) return;
+    i32 gx = x + g->x_offset * sx, gy = y + g->y_offset * sy;
+    if (!visible(gx, gy, gx + g->width * sx - 1, gy + g->height * sy - 1))
+      return;
     const u8* bmp = font_->bitmap;
     u16 bo = g->bitmap_offset;
     u8 bit = 0, bits = 0;
+    pixel_batch ink{*this, fg};
 
     for (u8 yy = 0; yy < g->height; yy++) {
       for (u8 xx = 0; xx < g->width; xx++) {
         if (!(bit++ & 7)) bits = bmp[bo++];
         if (bits & 0x80) {
           if (sx == 1 && sy == 1)
-            pixel(x + g->x_offset + xx, y + g->y_offset + yy, fg);
+            ink.put(x + g->x_offset + xx, y + g->y_offset + yy);
           else
             fill_rect(x + (g->x_offset + xx) * sx, y + (g->y_offset + yy) * sy,
                       sx, sy, fg);
@@ -439,22 +1611,209 @@ class canvas {
     }
   }
 
+  // rows are clipped once, then each run between key pixels is copied
   void draw_image_keyed(i16 x, i16 y, const image& img) {
-    for (i16 row = 0; row < static_cast<i16>(img.h); ++row) {
-      i16 screen_y = y + row;
-      if (screen_y < 0 || screen_y >= height()) continue;
-      for (i16 col = 0; col < static_cast<i16>(img.w); ++col) {
-        i16 screen_x = x + col;
-        if (screen_x < 0 || screen_x >= width()) continue;
-        u16 px = img.data[row * img.w + col];
-        if (px != img.color_key) pixel(screen_x, screen_y, px);
+    image_rows(x, y, img.w, img.h, [&](i16 dy, i16 dx, u16 sx, u16 sy, i16 n) {
+      put_row_keyed(dy, dx, &img.data[sy * img.w + sx], n, img.color_key);
+    });
+  }
+
+  void draw_transformed(i16 x, i16 y, u16 img_w, u16 img_h, const u16* data,
+                        transform t, const u16* key) {
+    u8 bits = static_cast<u8>(t);
+    bool swap = bits & 4, fx = bits & 1, fy = bits & 2;
+    i32 out_w = swap ? img_h : img_w, out_h = swap ? img_w : img_h;
+
+    jpico::rect c = clip();
+    point o = origin();
+    i32 left = x + o.x, top = y + o.y;
+    i32 x0 = std::max<i32>(left, c.x());
+    i32 x1 = std::min<i32>(left + out_w, c.right());
+    i32 y0 = std::max<i32>(top, c.y());
+    i32 y1 = std::min<i32>(top + out_h, c.bottom());
+    if (x0 >= x1 || y0 >= y1) return;
+
+    // source index steps per output column (du) and row (dv)
+    i32 sa = fx ? -1 : 1, sb = fy ? -1 : 1;
+    i32 du = swap ? sa * img_w : sa, dv = swap ? sb : sb * img_w;
+
+    u16 buf[tile_size * tile_size];
+    for (i32 ty = y0; ty < y1; ty += tile_size) {
+      i16 th = static_cast<i16>(std::min<i32>(tile_size, y1 - ty));
+      for (i32 tx = x0; tx < x1; tx += tile_size) {
+        i16 tw = static_cast<i16>(std::min<i32>(tile_size, x1 - tx));
+        i32 a = tx - left, b = ty - top;
+        if (fx) a = out_w - 1 - a;
+        if (fy) b = out_h - 1 - b;
+        i32 row = swap ? a * img_w + b : b * img_w + a;
+
+        u16* out = buf;
+        for (i16 v = 0; v < th; ++v, row += dv) {
+          i32 i = row;
+          for (i16 u = 0; u < tw; ++u, i += du) *out++ = data[i];
+        }
+        put_block(static_cast<i16>(ty), static_cast<i16>(tx), tw, th, buf, key);
       }
     }
   }
 
+  void draw_scaled(i16 x, i16 y, u16 dst_w, u16 dst_h, u16 img_w, u16 img_h,
+                   const u16* data, scale_filter filter, const u16* key) {
+    if (!dst_w || !dst_h || !img_w || !img_h) return;
+    jpico::rect c = clip();
+    point o = origin();
+    i32 left = x + o.x, top = y + o.y;
+    i32 x0 = std::max<i32>(left, c.x());
+    i32 x1 = std::min<i32>(left + dst_w, c.right());
+    i32 y0 = std::max<i32>(top, c.y());
+    i32 y1 = std::min<i32>(top + dst_h, c.bottom());
+    if (x0 >= x1 || y0 >= y1) return;
+
+    bool bilinear = filter == scale_filter::bilinear && !key &&
+                    !is_indexed(format());
+    u32 step_x = (static_cast<u32>(img_w) << 16) / dst_w;
+    u32 step_y = (static_cast<u32>(img_h) << 16) / dst_h;
+
+    u16 col[line_chunk];
+    u8 wx[line_chunk];
+    u16 buf[line_chunk];
+    for (i32 cx = x0; cx < x1; cx += line_chunk) {
+      i16 n = static_cast<i16>(std::min<i32>(line_chunk, x1 - cx));
+      i64 f = scale_start(cx - left, step_x, bilinear);
+      for (i16 i = 0; i < n; ++i, f += step_x) {
+        u32 v = scale_clamp(f, img_w);
+        col[i] = static_cast<u16>(v >> 16);
+        wx[i] = static_cast<u8>(v >> 8);
+      }
+
+      for (i32 sy = y0; sy < y1; ++sy) {
+        u32 fy = scale_clamp(scale_start(sy - top, step_y, bilinear), img_h);
+        u16 ry = static_cast<u16>(fy >> 16);
+        const u16* r0 = data + static_cast<usize>(ry) * img_w;
+        if (!bilinear) {
+          for (i16 i = 0; i < n; ++i) buf[i] = r0[col[i]];
+        } else {
+          const u16* r1 = ry + 1 < img_h ? r0 + img_w : r0;
+          u8 wy = static_cast<u8>(fy >> 8);
+          for (i16 i = 0; i < n; ++i) {
+            u16 c0 = col[i], c1 = c0 + 1 < img_w ? c0 + 1 : c0;
+            u16 t = blend565(r0[c1], r0[c0], wx[i]);
+            u16 b = blend565(r1[c1], r1[c0], wx[i]);
+            buf[i] = blend565(b, t, wy);
+          }
+        }
+        if (key) {
+          put_row_keyed(static_cast<i16>(sy), static_cast<i16>(cx), buf, n,
+                        *key);
+        } else {
+          put_row(static_cast<i16>(sy), static_cast<i16>(cx), buf, n);
+        }
+      }
+    }
+  }
+
+  // 16.16 source position of destination pixel d: its center for nearest,
+  // shifted half a source pixel for bilinear so weights fall between
+  // sample centers
+  static i64 scale_start(i32 d, u32 step, bool bilinear) {
+    i64 f = static_cast<i64>(d) * step + step / 2;
+    return bilinear ? f - 0x8000 : f;
+  }
+
+  static u32 scale_clamp(i64 f, u16 size) {
+    return static_cast<u32>(
+        std::clamp<i64>(f, 0, (static_cast<i64>(size) << 16) - 1));
+  }
+
+  void blend_row(i16 y, i16 x, const image& img, u16 sx, u16 sy, i16 n,
+                 u8 alpha) {
+    const u16* src = &img.data[sy * img.w + sx];
+    auto opacity = [&](i16 i) -> u8 {
+      if (img.use_color_key && src[i] == img.color_key) return 0;
+      u8 a = img.opacity(sx + i, sy);
+      return alpha == 255 ? a : static_cast<u8>((a * (alpha + 1)) >> 8);
+    };
+
+    if (framebuffer_ && format() == pixel_format::rgb565) {
+      u16* dst = row565(y) + x;
+      if (!img.alpha && !img.use_color_key) {
+        for (i16 i = 0; i < n; ++i) dst[i] = blend565(src[i], dst[i], alpha);
+      } else {
+        for (i16 i = 0; i < n; ++i) {
+          u8 a = opacity(i);
+          if (a) dst[i] = a == 255 ? src[i] : blend565(src[i], dst[i], a);
+        }
+      }
+      framebuffer_dirty_ = true;
+      return;
+    }
+    if (framebuffer_ && format() == pixel_format::rgb565_be) {
+      u16* dst = row565(y) + x;
+      for (i16 i = 0; i < n; ++i) {
+        u8 a = opacity(i);
+        if (!a) continue;
+        u16 c = a == 255 ? src[i] : blend565(src[i], std::byteswap(dst[i]), a);
+        dst[i] = std::byteswap(c);
+      }
+      framebuffer_dirty_ = true;
+      return;
+    }
+    if (!framebuffer_ && readback_) {
+      u16 buf[line_chunk];
+      for (i16 s = 0; s < n; s += line_chunk) {
+        i16 m = std::min<i16>(line_chunk, n - s);
+        if (!read_row(y, x + s, m, buf)) {
+          readback_ = false;
+          break;
+        }
+        for (i16 i = 0; i < m; ++i) {
+          u8 a = opacity(s + i);
+          if (a == 255) {
+            buf[i] = src[s + i];
+          } else if (a) {
+            buf[i] = blend565(src[s + i], buf[i], a);
+          }
+        }
+        put_row(y, x + s, buf, m);
+      }
+      if (readback_) return;
+    }
+
+    for (i16 i = 0; i < n;) {
+      while (i < n && opacity(i) < 128) ++i;
+      i16 s = i;
+      while (i < n && opacity(i) >= 128) ++i;
+      if (i > s) put_row(y, x + s, src + s, i - s);
+    }
+  }
+
   D& display_;
-  std::unique_ptr<u16[]> framebuffer_;
+  u16* framebuffer_ = nullptr;
+  u16* line_ = nullptr;  // flush expansion buffer, indexed only
+  std::unique_ptr<u16[]> heap_;
+  std::unique_ptr<u16[]> heap_line_;
+  usize stride_ = 0;  // heap storage; see stride()
+  pixel_format format_ = pixel_format::rgb565;
+  u16 palette_[256] = {};
   bool framebuffer_dirty_ = false;
+  bool hw_scroll_ = false;
+  bool readback_ = false;  // direct-mode blending reads the panel
+  i16 scroll_offset_ = 0;  // panel row holding canvas row 0
+  clip_state clip_stack_[max_clip_depth] = {};
+  u8 clip_depth_ = 0;
+
+  std::unique_ptr<u32[]> tile_hashes_;  // tile flush mode when set
+  tile_hash_fn tile_hash_ = hash_rows;
+  void* tile_ctx_ = nullptr;
+  u16 tile_ = 32;
+  u16 tile_cols_ = 0;
+  u16 tile_rows_ = 0;
+  bool tiles_valid_ = false;
+  tile_stats tile_stats_;
+
+  frame_stats frame_;  // in progress
+  frame_stats last_frame_;
+  u32 frame_start_ = stats_now_us();
 
   i16 cursor_x_ = 0;
   i16 cursor_y_ = 0;
@@ -467,4 +1826,11 @@ class canvas {
   const font* font_ = nullptr;
 };
 
+template <display D>
+canvas(D&) -> canvas<D>;
+
+template <display D, u16 W, u16 H, pixel_format F>
+canvas(D&, static_framebuffer<W, H, F>&)
+    -> canvas<D, static_framebuffer<W, H, F>>;
+
 }  // namespace jpico::graphics
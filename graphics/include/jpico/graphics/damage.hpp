@@ -0,0 +1,60 @@
+#pragma once
+#include <jpico/types.hpp>
+
+namespace jpico::graphics {
+
+// up to N disjoint dirty rects. an added rect absorbs every rect it
+// overlaps; once N are pending the next one is folded into whichever grows
+// the least, so coverage is never lost, only coarsened.
+template <usize N>
+class damage_list {
+ public:
+  void add(rect r) {
+    if (r.empty()) return;
+    for (usize i = 0; i < count_;) {
+      if (rects_[i].intersects(r)) {
+        r = r.united(rects_[i]);
+        rects_[i] = rects_[--count_];
+        i = 0;
+      } else {
+        ++i;
+      }
+    }
+    if (count_ < N) {
+      rects_[count_++] = r;
+      return;
+    }
+    usize best = 0;
+    u32 best_cost = ~0u;
+    for (usize i = 0; i < count_; ++i) {
+      u32 cost = rects_[i].united(r).dims.area() - rects_[i].dims.area();
+      if (cost < best_cost) {
+        best = i;
+        best_cost = cost;
+      }
+    }
+    r = r.united(rects_[best]);
+    rects_[best] = rects_[--count_];
+    add(r);
+  }
+
+  void clear() { count_ = 0; }
+
+  bool empty() const { return count_ == 0; }
+  usize size() const { return count_; }
+  const rect& operator[](usize i) const { return rects_[i]; }
+  const rect* begin() const { return rects_; }
+  const rect* end() const { return rects_ + count_; }
+
+  rect bounds() const {
+    rect b{};
+    for (usize i = 0; i < count_; ++i) b = b.united(rects_[i]);
+    return b;
+  }
+
+ private:
+  rect rects_[N] = {};
+  usize count_ = 0;
+};
+
+}  // namespace jpico::graphics
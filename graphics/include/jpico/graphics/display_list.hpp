@@ -0,0 +1,575 @@
+#pragma once
+#include <cstring>
+#include <jpico/graphics/canvas.hpp>
+#include <jpico/graphics/damage.hpp>
+#include <jpico/graphics/text.hpp>
+#include <jpico/types.hpp>
+#include <span>
+
+namespace jpico::graphics {
+
+// records canvas calls as compact bytecode in a caller-provided arena and
+// replays them onto any canvas. each record carries its bounding box in
+// screen coordinates (narrowed by recorded clips), so a replay can skip
+// records outside a clip rect and two recordings can be diffed without
+// rasterizing. images and fonts are referenced and must outlive the list;
+// text is copied. when the arena is full further records are dropped and
+// overflowed() says so.
+class display_list {
+ public:
+  explicit display_list(std::span<u8> arena) : arena_{arena} {}
+
+  void reset() {
+    used_ = 0;
+    overflowed_ = false;
+    clip_depth_ = 0;
+  }
+
+  usize size() const { return used_; }  // bytes recorded
+  usize capacity() const { return arena_.size(); }
+  bool overflowed() const { return overflowed_; }
+
+  // recording. same meaning as the canvas calls of the same name.
+
+  void fill(u16 color) {
+    emit(op::fill, clip_depth_ ? clip_[clip_depth_ - 1] : everything,
+         fill_args{color});
+  }
+
+  void pixel(i16 x, i16 y, u16 color) {
+    emit(op::pixel, {{x, y}, {1, 1}}, pixel_args{x, y, color});
+  }
+
+  void line(i16 x0, i16 y0, i16 x1, i16 y1, u16 color, u16 thickness = 1,
+            line_cap cap = line_cap::butt) {
+    i16 pad = static_cast<i16>(thickness / 2 + 1);
+    emit(op::line,
+         box(std::min(x0, x1) - pad, std::min(y0, y1) - pad,
+             std::max(x0, x1) + pad, std::max(y0, y1) + pad),
+         line_args{x0, y0, x1, y1, color, thickness, cap});
+  }
+
+  void hline(i16 x, i16 y, i16 length, u16 color) {
+    if (length <= 0) return;
+    emit(op::hline, box(x, y, x + length - 1, y),
+         span_args{x, y, length, color});
+  }
+
+  void vline(i16 x, i16 y, i16 h, u16 color) {
+    if (h <= 0) return;
+    emit(op::vline, box(x, y, x, y + h - 1), span_args{x, y, h, color});
+  }
+
+  void rect(i16 x, i16 y, i16 w, i16 h, u16 color) {
+    if (w <= 0 || h <= 0) return;
+    emit(op::rect, box(x, y, x + w - 1, y + h - 1),
+         rect_args{x, y, w, h, color});
+  }
+
+  void fill_rect(i16 x, i16 y, i16 w, i16 h, u16 color) {
+    if (w <= 0 || h <= 0) return;
+    emit(op::fill_rect, box(x, y, x + w - 1, y + h - 1),
+         rect_args{x, y, w, h, color});
+  }
+
+  void circle(i16 x, i16 y, i16 r, u16 color) {
+    if (r < 0) return;
+    emit(op::circle, box(x - r, y - r, x + r, y + r),
+         circle_args{x, y, r, color});
+  }
+
+  void fill_circle(i16 x, i16 y, i16 r, u16 color) {
+    if (r < 0) return;
+    fill_arc(x, y, static_cast<u16>(r), 0, 0, 360, color);
+  }
+
+  void fill_arc(i16 cx, i16 cy, u16 r_outer, u16 r_inner, i16 start, i16 end,
+                u16 color) {
+    emit(op::arc, box(cx - r_outer, cy - r_outer, cx + r_outer, cy + r_outer),
+         arc_args{cx, cy, r_outer, r_inner, start, end, color});
+  }
+
+  void fill_pie(i16 cx, i16 cy, u16 r, i16 start, i16 end, u16 color) {
+    fill_arc(cx, cy, r, 0, start, end, color);
+  }
+
+  void arc(i16 cx, i16 cy, u16 r, i16 start, i16 end, u16 color,
+           u16 thickness = 1) {
+    if (thickness == 0) return;
+    u16 inner = thickness > r ? 0 : static_cast<u16>(r - thickness + 1);
+    fill_arc(cx, cy, r, inner, start, end, color);
+  }
+
+  void fill_round_rect(i16 x, i16 y, i16 w, i16 h, u16 r, u16 color) {
+    round_rect(x, y, w, h, r, color, 0);
+  }
+
+  // thickness 0 fills
+  void round_rect(i16 x, i16 y, i16 w, i16 h, u16 r, u16 color,
+                  u16 thickness = 1) {
+    if (w <= 0 || h <= 0) return;
+    emit(op::round_rect, box(x, y, x + w - 1, y + h - 1),
+         round_rect_args{x, y, w, h, r, color, thickness});
+  }
+
+  void fill_triangle(i16 x0, i16 y0, i16 x1, i16 y1, i16 x2, i16 y2,
+                     u16 color) {
+    point pts[3] = {{x0, y0}, {x1, y1}, {x2, y2}};
+    fill_polygon(pts, color);
+  }
+
+  void fill_polygon(std::span<const point> pts, u16 color,
+                    fill_rule rule = fill_rule::non_zero) {
+    if (pts.size() < 3 || pts.size() > max_polygon_points) return;
+    i16 x0 = pts[0].x, y0 = pts[0].y, x1 = x0, y1 = y0;
+    for (const point& p : pts) {
+      x0 = std::min(x0, p.x);
+      y0 = std::min(y0, p.y);
+      x1 = std::max(x1, p.x);
+      y1 = std::max(y1, p.y);
+    }
+    emit(op::polygon, box(x0, y0, x1, y1),
+         polygon_args{color, rule, static_cast<u8>(pts.size())}, pts.data(),
+         pts.size_bytes());
+  }
+
+  void draw_image(i16 x, i16 y, const image& img, u8 alpha = 255) {
+    emit(op::image, {{x, y}, {img.w, img.h}},
+         image_args{x, y, &img, alpha, transform::none});
+  }
+
+  void draw_image(i16 x, i16 y, const image& img, transform t) {
+    bool swap = static_cast<u8>(t) & 4;
+    emit(op::image,
+         {{x, y}, {swap ? img.h : img.w, swap ? img.w : img.h}},
+         image_args{x, y, &img, 255, t});
+  }
+
+  void draw_image(i16 x, i16 y, const palette_image& img) {
+    emit(op::palette_image, {{x, y}, {img.w, img.h}},
+         ref_args<palette_image>{x, y, &img});
+  }
+
+  void draw_image(i16 x, i16 y, const rle_image& img) {
+    emit(op::rle_image, {{x, y}, {img.w, img.h}},
+         ref_args<rle_image>{x, y, &img});
+  }
+
+  void draw_image_scaled(i16 x, i16 y, u16 dst_w, u16 dst_h, const image& img,
+                         scale_filter filter = scale_filter::nearest) {
+    emit(op::image_scaled, {{x, y}, {dst_w, dst_h}},
+         scaled_args{x, y, dst_w, dst_h, &img, filter});
+  }
+
+  // utf-8 text at (x, y) without wrapping; '\n' returns to x on the next
+  // line. f null selects the builtin 5x7 font. long strings are recorded
+  // in chunks of up to max_text_chunk bytes, split between characters.
+  void text(i16 x, i16 y, const char* str, u16 fg, u16 bg, const font* f,
+            u8 sx = 1, u8 sy = 1) {
+    char chunk[max_text_chunk + 1];
+    point pen{x, y};
+    for (usize n = std::strlen(str); n;) {
+      usize k = std::min(n, max_text_chunk);
+      usize whole = k;
+      while (k < n && k && (static_cast<u8>(str[k]) & 0xC0) == 0x80) --k;
+      if (!k) k = whole;  // no character boundary: malformed anyway
+      std::memcpy(chunk, str, k);
+      chunk[k] = '\0';
+      text_args a{x, pen.x, pen.y, fg, bg, f, sx, sy, static_cast<u8>(k)};
+      jpico::rect b{};
+      pen = walk_text(a, chunk, [&](i32 cx, i32 cy, u32 cp) {
+        b = b.united(glyph_box(cx, cy, cp, f, sx, sy));
+      });
+      emit(op::text, b, a, chunk, k + 1);
+      str += k;
+      n -= k;
+    }
+  }
+
+  // narrows later records like canvas::push_clip. pushes beyond the
+  // canvas stack depth are dropped along with their pop.
+  void push_clip(jpico::rect r) {
+    if (clip_depth_ == max_clip_depth) {
+      ++dropped_clips_;
+      return;
+    }
+    if (clip_depth_) r = r.intersection(clip_[clip_depth_ - 1]);
+    if (!emit(op::push_clip, r, clip_args{r}, nullptr, 0, true)) return;
+    clip_[clip_depth_++] = r;
+  }
+
+  void pop_clip() {
+    if (dropped_clips_) {
+      --dropped_clips_;
+      return;
+    }
+    if (!clip_depth_) return;
+    if (emit(op::pop_clip, clip_[clip_depth_ - 1], pop_args{}, nullptr, 0,
+             true)) {
+      --clip_depth_;
+    }
+  }
+
+  // replay everything
+  template <display D, typename S>
+  void replay(canvas<D, S>& c) const {
+    play(c, nullptr);
+  }
+
+  // replay only what intersects `clip`, with drawing clipped to it: the
+  // cheap way to repaint a damaged region
+  template <display D, typename S>
+  void replay(canvas<D, S>& c, jpico::rect clip) const {
+    if (!c.push_clip(clip)) return;
+    play(c, &clip);
+    c.pop_clip();
+  }
+
+  // regions that differ between two recordings of the same screen, found
+  // from the records alone. records are matched in order: identical pairs
+  // are skipped, and both bounds of any pair that differs (or has no
+  // partner) are damaged, so keep the stable content of a frame first.
+  template <usize N>
+  static void diff(const display_list& before, const display_list& after,
+                   damage_list<N>& out) {
+    usize i = 0, j = 0;
+    while (i < before.used_ || j < after.used_) {
+      header a{}, b{};
+      if (i < before.used_) std::memcpy(&a, before.at(i), sizeof(a));
+      if (j < after.used_) std::memcpy(&b, after.at(j), sizeof(b));
+      bool same = a.size && a.size == b.size &&
+                  std::memcmp(before.at(i), after.at(j), a.size) == 0;
+      if (!same) {
+        out.add(a.bounds);
+        out.add(b.bounds);
+      }
+      i += a.size;
+      j += b.size;
+    }
+  }
+
+ private:
+  enum class op : u8 {
+    fill,
+    pixel,
+    line,
+    hline,
+    vline,
+    rect,
+    fill_rect,
+    circle,
+    arc,
+    round_rect,
+    polygon,
+    image,
+    palette_image,
+    rle_image,
+    image_scaled,
+    text,
+    push_clip,
+    pop_clip,
+  };
+
+  // every record: header, fixed args, then optional trailing bytes. all
+  // packed, so records compare bytewise in diff()
+  struct header {
+    jpico::rect bounds;
+    u16 size;  // whole record
+    op code;
+    u8 reserved;
+  };
+
+  struct [[gnu::packed]] fill_args {
+    u16 color;
+  };
+  struct [[gnu::packed]] pixel_args {
+    i16 x, y;
+    u16 color;
+  };
+  struct [[gnu::packed]] line_args {
+    i16 x0, y0, x1, y1;
+    u16 color, thickness;
+    line_cap cap;
+  };
+  struct [[gnu::packed]] span_args {
+    i16 x, y, length;
+    u16 color;
+  };
+  struct [[gnu::packed]] rect_args {
+    i16 x, y, w, h;
+    u16 color;
+  };
+  struct [[gnu::packed]] circle_args {
+    i16 x, y, r;
+    u16 color;
+  };
+  struct [[gnu::packed]] arc_args {
+    i16 cx, cy;
+    u16 r_outer, r_inner;
+    i16 start, end;
+    u16 color;
+  };
+  struct [[gnu::packed]] round_rect_args {
+    i16 x, y, w, h;
+    u16 r, color, thickness;
+  };
+  struct [[gnu::packed]] polygon_args {
+    u16 color;
+    fill_rule rule;
+    u8 count;  // points follow
+  };
+  struct [[gnu::packed]] image_args {
+    i16 x, y;
+    const image* img;
+    u8 alpha;
+    transform t;
+  };
+  template <typename Image>
+  struct [[gnu::packed]] ref_args {
+    i16 x, y;
+    const Image* img;
+  };
+  struct [[gnu::packed]] scaled_args {
+    i16 x, y;
+    u16 w, h;
+    const image* img;
+    scale_filter filter;
+  };
+  struct [[gnu::packed]] text_args {
+    i16 left;  // where '\n' returns to
+    i16 x, y;
+    u16 fg, bg;
+    const font* f;
+    u8 sx, sy, length;  // utf-8 bytes follow, then a nul
+  };
+
+  static constexpr usize max_text_chunk = 254;
+  struct clip_args {
+    jpico::rect r;
+  };
+  struct [[gnu::packed]] pop_args {};
+
+  static constexpr jpico::rect everything{{0, 0}, {0x7FFF, 0x7FFF}};
+
+  // inclusive corners to a rect, empty if inverted
+  static jpico::rect box(i32 x0, i32 y0, i32 x1, i32 y1) {
+    if (x1 < x0 || y1 < y0) return {};
+    return {{static_cast<i16>(x0), static_cast<i16>(y0)},
+            {static_cast<u16>(x1 - x0 + 1), static_cast<u16>(y1 - y0 + 1)}};
+  }
+
+  // steps through nul-terminated utf-8 the way replay draws it, calling
+  // fn(x, y, codepoint) per character; returns the pen position after
+  template <typename Fn>
+  static point walk_text(const text_args& a, const char* s, Fn&& fn) {
+    i32 cx = a.x, cy = a.y;
+    while (*s) {
+      u32 cp = utf8_next(s);
+      if (cp == '\n' || cp == '\r') {
+        cx = a.left;
+        if (cp == '\n') cy += (a.f ? a.f->y_advance : 8) * a.sy;
+        continue;
+      }
+      fn(cx, cy, cp);
+      if (!a.f) {
+        cx += 6 * a.sx;
+      } else if (const glyph* g = find_glyph(*a.f, cp)) {
+        cx += g->x_advance * a.sx;
+      }
+    }
+    return {static_cast<i16>(cx), static_cast<i16>(cy)};
+  }
+
+  // ink of one character with its pen at (x, y)
+  static jpico::rect glyph_box(i32 x, i32 y, u32 cp, const font* f, u8 sx,
+                               u8 sy) {
+    if (!f) {
+      if (cp < 32 || cp > 126) return {};
+      return box(x, y, x + 5 * sx - 1, y + 8 * sy - 1);
+    }
+    const glyph* g = find_glyph(*f, cp);
+    if (!g) return {};
+    i32 gx = x + g->x_offset * sx, gy = y + g->y_offset * sy;
+    return box(gx, gy, gx + g->width * sx - 1, gy + g->height * sy - 1);
+  }
+
+  const u8* at(usize offset) const { return arena_.data() + offset; }
+
+  // appends a record. draw records wholly outside the recorded clip are
+  // dropped; clip records are always kept.
+  template <typename Args>
+  bool emit(op code, jpico::rect bounds, const Args& args,
+            const void* extra = nullptr, usize extra_len = 0,
+            bool structural = false) {
+    if (!structural) {
+      if (clip_depth_) bounds = bounds.intersection(clip_[clip_depth_ - 1]);
+      if (bounds.empty()) return false;
+    }
+    usize size = sizeof(header) + sizeof(Args) + extra_len;
+    if (overflowed_ || size > 0xFFFF || used_ + size > arena_.size()) {
+      overflowed_ = true;
+      return false;
+    }
+    header h{bounds, static_cast<u16>(size), code, 0};
+    u8* p = arena_.data() + used_;
+    std::memcpy(p, &h, sizeof(h));
+    std::memcpy(p + sizeof(header), &args, sizeof(Args));
+    if (extra_len) {
+      std::memcpy(p + sizeof(header) + sizeof(Args), extra, extra_len);
+    }
+    used_ += size;
+    return true;
+  }
+
+  template <typename Args>
+  static Args load(const u8* p) {
+    Args a;
+    std::memcpy(&a, p + sizeof(header), sizeof(Args));
+    return a;
+  }
+
+  template <display D, typename S>
+  void play(canvas<D, S>& c, const jpico::rect* clip) const {
+    u16 pushed = 0;  // bit per nesting level: did the canvas accept it
+    u8 depth = 0;
+    for (usize off = 0; off < used_;) {
+      const u8* p = at(off);
+      header h;
+      std::memcpy(&h, p, sizeof(h));
+      off += h.size;
+
+      if (h.code == op::push_clip) {
+        if (c.push_clip(load<clip_args>(p).r)) pushed |= 1u << depth;
+        ++depth;
+        continue;
+      }
+      if (h.code == op::pop_clip) {
+        if (!depth) continue;
+        --depth;
+        if (pushed & (1u << depth)) c.pop_clip();
+        pushed &= ~(1u << depth);
+        continue;
+      }
+      if (clip && !h.bounds.intersects(*clip)) continue;
+      draw(c, h.code, p);
+    }
+    for (; depth; --depth) {
+      if (pushed & (1u << (depth - 1))) c.pop_clip();
+    }
+  }
+
+  template <display D, typename S>
+  static void draw(canvas<D, S>& c, op code, const u8* p) {
+    switch (code) {
+      case op::fill:
+        c.fill(load<fill_args>(p).color);
+        break;
+      case op::pixel: {
+        auto a = load<pixel_args>(p);
+        c.pixel(a.x, a.y, a.color);
+        break;
+      }
+      case op::line: {
+        auto a = load<line_args>(p);
+        c.line(a.x0, a.y0, a.x1, a.y1, a.color, a.thickness, a.cap);
+        break;
+      }
+      case op::hline: {
+        auto a = load<span_args>(p);
+        c.hline(a.x, a.y, a.length, a.color);
+        break;
+      }
+      case op::vline: {
+        auto a = load<span_args>(p);
+        c.vline(a.x, a.y, a.length, a.color);
+        break;
+      }
+      case op::rect: {
+        auto a = load<rect_args>(p);
+        c.rect(a.x, a.y, a.w, a.h, a.color);
+        break;
+      }
+      case op::fill_rect: {
+        auto a = load<rect_args>(p);
+        c.fill_rect(a.x, a.y, a.w, a.h, a.color);
+        break;
+      }
+      case op::circle: {
+        auto a = load<circle_args>(p);
+        c.circle(a.x, a.y, a.r, a.color);
+        break;
+      }
+      case op::arc: {
+        auto a = load<arc_args>(p);
+        c.fill_arc(a.cx, a.cy, a.r_outer, a.r_inner, a.start, a.end, a.color);
+        break;
+      }
+      case op::round_rect: {
+        auto a = load<round_rect_args>(p);
+        if (a.thickness) {
+          c.round_rect(a.x, a.y, a.w, a.h, a.r, a.color, a.thickness);
+        } else {
+          c.fill_round_rect(a.x, a.y, a.w, a.h, a.r, a.color);
+        }
+        break;
+      }
+      case op::polygon: {
+        auto a = load<polygon_args>(p);
+        point pts[max_polygon_points];
+        std::memcpy(pts, p + sizeof(header) + sizeof(a),
+                    a.count * sizeof(point));
+        c.fill_polygon(std::span<const point>(pts, a.count), a.color, a.rule);
+        break;
+      }
+      case op::image: {
+        auto a = load<image_args>(p);
+        if (a.t != transform::none) {
+          c.draw_image(a.x, a.y, *a.img, a.t);
+        } else {
+          c.draw_image(a.x, a.y, *a.img, a.alpha);
+        }
+        break;
+      }
+      case op::palette_image: {
+        auto a = load<ref_args<palette_image>>(p);
+        c.draw_image(a.x, a.y, *a.img);
+        break;
+      }
+      case op::rle_image: {
+        auto a = load<ref_args<rle_image>>(p);
+        c.draw_image(a.x, a.y, *a.img);
+        break;
+      }
+      case op::image_scaled: {
+        auto a = load<scaled_args>(p);
+        c.draw_image_scaled(a.x, a.y, a.w, a.h, *a.img, a.filter);
+        break;
+      }
+      case op::text: {
+        auto a = load<text_args>(p);
+        const char* s =
+            reinterpret_cast<const char*>(p + sizeof(header) + sizeof(a));
+        const font* saved = c.current_font();
+        c.set_font(a.f);
+        walk_text(a, s, [&](i32 x, i32 y, u32 cp) {
+          c.draw_glyph(static_cast<i16>(x), static_cast<i16>(y), cp, a.fg,
+                       a.bg, a.sx, a.sy);
+        });
+        c.set_font(saved);
+        break;
+      }
+      case op::push_clip:
+      case op::pop_clip:
+        break;
+    }
+  }
+
+  std::span<u8> arena_;
+  usize used_ = 0;
+  bool overflowed_ = false;
+  jpico::rect clip_[max_clip_depth] = {};
+  u8 clip_depth_ = 0;
+  u8 dropped_clips_ = 0;
+};
+
+}  // namespace jpico::graphics
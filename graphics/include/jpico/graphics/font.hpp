@@ -12,12 +12,43 @@ struct glyph {
   i8 y_offset;
 };
 
+// a run of consecutive codepoints backed by consecutive glyphs.
+struct glyph_range {
+  u32 first;
+  u16 count;
+  u16 glyph;  // index into font::glyphs of the glyph for `first`
+};
+
 struct font {
   const u8* bitmap;
   const glyph* glyphs;
   u8 first;
   u8 last;
   u8 y_advance;
+
+  // optional sparse index, sorted by first. when set, first/last are ignored.
+  const glyph_range* ranges = nullptr;
+  u16 range_count = 0;
 };
 
+constexpr const glyph* find_glyph(const font& f, u32 cp) {
+  if (!f.ranges) {
+    if (cp < f.first || cp > f.last) return nullptr;
+    return &f.glyphs[cp - f.first];
+  }
+
+  u16 lo = 0, hi = f.range_count;
+  while (lo < hi) {
+    u16 mid = static_cast<u16>((lo + hi) / 2);
+    const glyph_range& r = f.ranges[mid];
+    if (cp < r.first)
+      hi = mid;
+    else if (cp >= r.first + r.count)
+      lo = static_cast<u16>(mid + 1);
+    else
+      return &f.glyphs[r.glyph + (cp - r.first)];
+  }
+  return nullptr;
+}
+
 }  // namespace jpico::graphics
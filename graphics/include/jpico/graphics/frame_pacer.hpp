@@ -0,0 +1,156 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <jpico/concepts.hpp>
+#include <jpico/graphics/canvas.hpp>
+#include <jpico/platform.hpp>
+#include <jpico/types.hpp>
+
+#if JPICO_ON_DEVICE
+#include "hardware/sync.h"
+#else
+#include <chrono>
+#include <thread>
+#endif
+
+namespace jpico::graphics {
+
+// the fastest refresh that a full-screen write of `pixels` rgb565 pixels
+// at `baudrate` can chase: started on a TE edge in scan order, it stays
+// clear of the scan line while it takes at most two refresh periods. the
+// rate is sized for 1.8 periods, leaving a tenth of the budget for the
+// window commands, the interrupt latency and the last band still in
+// flight. hand it to the driver's set_frame_rate().
+constexpr u32 chase_rate_hz(u32 baudrate, u32 pixels) {
+  return pixels ? static_cast<u32>(9ull * baudrate / (5ull * 16 * pixels))
+                : 0;
+}
+
+// what a frame_pacer saw since the last reset
+struct pacing_stats {
+  u32 frames = 0;    // released by wait()
+  u32 missed = 0;    // ready only after their edge had passed
+  u32 skipped = 0;   // edges those frames gave up
+  u32 overruns = 0;  // flushes still going two edges after they started,
+                     // overtaken by the scan line
+};
+
+// presents frames on the panel's tearing-effect edges. each frame is due
+// `interval` edges after the one before; present() sleeps until that edge
+// and then flushes in the order that chases the scan. a frame ready only
+// after its edge has passed misses its deadline: it waits for the next
+// edge and the schedule restarts from there.
+//
+// vsync() counts the edges. on the device it runs from the TE pin:
+//
+//   lcd.set_tearing_effect(true);
+//   lcd.set_frame_rate(graphics::chase_rate_hz(40'000'000, 240 * 320));
+//   static graphics::frame_pacer pacer;
+//   hal::input_pin te(22);
+//   hal::edge_irq irq(te, graphics::frame_pacer::on_edge, &pacer);
+//   auto order = lcd.scan_bottom_up() ? graphics::flush_order::bottom_up
+//                                     : graphics::flush_order::top_down;
+//   for (;;) { draw(canvas); pacer.present(canvas, order); }
+//
+// host builds drive it with a simulated_te, or call vsync() themselves.
+class frame_pacer {
+ public:
+  explicit frame_pacer(u8 interval = 1)
+      : interval_{std::max<u8>(interval, 1)} {}
+
+  frame_pacer(const frame_pacer&) = delete;
+  frame_pacer& operator=(const frame_pacer&) = delete;
+
+  // one TE edge. the interrupt is the only writer, so the count needs no
+  // atomic read-modify-write (which the rp2040 lacks)
+  void vsync() {
+    edges_.store(edges_.load(std::memory_order_relaxed) + 1,
+                 std::memory_order_release);
+#if JPICO_ON_DEVICE
+    __sev();
+#endif
+  }
+
+  // hal::edge_irq handler; `self` is the pacer
+  static void on_edge(void* self) { static_cast<frame_pacer*>(self)->vsync(); }
+
+  u32 edges() const { return edges_.load(std::memory_order_acquire); }
+
+  // blocks until the next frame's edge has arrived and returns its number
+  u32 wait() {
+    u32 now = edges();
+    u32 due = last_ + interval_;
+    if (!started_) {
+      due = now + 1;
+    } else if (static_cast<i32>(now - due) >= 0) {
+      ++stats_.missed;
+      stats_.skipped += now + 1 - due;
+      due = now + 1;
+    }
+    while (static_cast<i32>(edges() - due) < 0) {
+#if JPICO_ON_DEVICE
+      __wfe();
+#else
+      std::this_thread::yield();
+#endif
+    }
+    last_ = due;
+    started_ = true;
+    ++stats_.frames;
+    return due;
+  }
+
+  // wait() and flush the canvas's framebuffer from the edge
+  template <display D, typename S>
+  void present(canvas<D, S>& c, flush_order order = flush_order::top_down) {
+    u32 edge = wait();
+    c.flush(order);
+    if (edges() - edge >= 2) ++stats_.overruns;
+  }
+
+  // start a new schedule: the next frame goes on the next edge
+  void restart() { started_ = false; }
+
+  u8 interval() const { return interval_; }
+  void set_interval(u8 interval) { interval_ = std::max<u8>(interval, 1); }
+
+  const pacing_stats& stats() const { return stats_; }
+  void reset_stats() { stats_ = {}; }
+
+ private:
+  std::atomic<u32> edges_{0};
+  u32 last_ = 0;  // edge the last frame went on
+  u8 interval_;
+  bool started_ = false;
+  pacing_stats stats_;
+};
+
+#if !JPICO_ON_DEVICE
+// host stand-in for the TE pin: a thread calling vsync() every period
+class simulated_te {
+ public:
+  simulated_te(frame_pacer& pacer, u32 period_us)
+      : thread_{[this, &pacer, period_us] {
+          auto next = std::chrono::steady_clock::now();
+          while (running_.load(std::memory_order_acquire)) {
+            next += std::chrono::microseconds(period_us);
+            std::this_thread::sleep_until(next);
+            pacer.vsync();
+          }
+        }} {}
+
+  ~simulated_te() {
+    running_.store(false, std::memory_order_release);
+    thread_.join();
+  }
+
+  simulated_te(const simulated_te&) = delete;
+  simulated_te& operator=(const simulated_te&) = delete;
+
+ private:
+  std::atomic<bool> running_{true};
+  std::thread thread_;
+};
+#endif
+
+}  // namespace jpico::graphics
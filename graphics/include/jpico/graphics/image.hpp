@@ -0,0 +1,142 @@
+#pragma once
+#include <jpico/types.hpp>
+
+namespace jpico::graphics {
+
+struct image {
+  u16 w;
+  u16 h;
+  const u16* data;  // row-major rgb565 pixels, w * h entries
+
+  u16 color_key = 0;
+  bool use_color_key = false;
+
+  // optional per-pixel opacity. a8 is one byte per pixel; a4 packs two
+  // pixels per byte, high nibble first, rows starting on a byte boundary.
+  const u8* alpha = nullptr;
+  u8 alpha_bits = 8;
+
+  constexpr u8 opacity(u16 x, u16 y) const {
+    if (!alpha) return 255;
+    if (alpha_bits == 8) return alpha[static_cast<usize>(y) * w + x];
+    u8 b = alpha[static_cast<usize>(y) * ((w + 1) / 2) + x / 2];
+    return static_cast<u8>(((x & 1) ? b & 0x0F : b >> 4) * 17);
+  }
+};
+
+// indexed image: 1/2/4/8 bits per pixel into an rgb565 palette.
+// rows are packed msb-first and start on a byte boundary.
+struct palette_image {
+  u16 w;
+  u16 h;
+  u8 bpp;
+  const u8* data;
+  const u16* palette;
+
+  u16 color_key = 0;  // palette index, not a color
+  bool use_color_key = false;
+
+  constexpr usize stride() const { return (static_cast<usize>(w) * bpp + 7) / 8; }
+
+  constexpr u8 index(u16 x, u16 y) const {
+    usize bit = static_cast<usize>(x) * bpp;
+    u8 byte = data[y * stride() + bit / 8];
+    u8 shift = static_cast<u8>(8 - bpp - (bit & 7));
+    return static_cast<u8>((byte >> shift) & ((1u << bpp) - 1));
+  }
+};
+
+// compressed rgb565, qoi-style. each row is a sequence of ops that never
+// cross a row boundary:
+//   00nnnnnn               -> skip n + 1 pixels (transparent)
+//   01nnnnnn               -> repeat the previous color n + 1 times
+//   10iiiiii               -> one pixel, color from the 64-entry cache
+//   11nnnnnn (lo hi)*(n+1) -> n + 1 literal colors, little-endian
+// the cache starts zeroed and every literal is stored at rle_hash(color).
+// the previous color starts as 0 and is unchanged by skips.
+struct rle_image {
+  u16 w;
+  u16 h;
+  const u8* data;
+  u32 size;  // bytes in data
+};
+
+constexpr u8 rle_hash(u16 c) {
+  return static_cast<u8>((c ^ (c >> 6) ^ (c >> 11)) & 63);
+}
+
+namespace detail {
+
+// streaming rle_image reader. hands out pixels op by op without a
+// decompression buffer; skipping touches only op headers and literals.
+class rle_reader {
+ public:
+  constexpr explicit rle_reader(const u8* data) : p_{data} {}
+
+  // pixels left in the current op, loading the next op if needed
+  constexpr u8 fetch() {
+    if (!left_) next_op();
+    return left_;
+  }
+
+  constexpr bool transparent() const { return op_ == op_skip; }
+
+  // decode n opaque pixels of the current op into out, n <= fetch()
+  constexpr void read(u16* out, usize n) {
+    if (op_ == op_literal) {
+      for (usize i = 0; i < n; ++i, p_ += 2) out[i] = remember(load(p_));
+    } else {
+      for (usize i = 0; i < n; ++i) out[i] = color_;
+    }
+    left_ -= static_cast<u8>(n);
+  }
+
+  // advance n pixels without producing them, across ops
+  constexpr void skip(usize n) {
+    while (n) {
+      usize k = n < fetch() ? n : left_;
+      if (op_ == op_literal) {
+        for (usize i = 0; i < k; ++i, p_ += 2) remember(load(p_));
+      }
+      n -= k;
+      left_ -= static_cast<u8>(k);
+    }
+  }
+
+ private:
+  static constexpr u8 op_skip = 0;
+  static constexpr u8 op_run = 1;
+  static constexpr u8 op_index = 2;
+  static constexpr u8 op_literal = 3;
+
+  static constexpr u16 load(const u8* p) {
+    return static_cast<u16>(p[0] | (p[1] << 8));
+  }
+
+  constexpr u16 remember(u16 c) {
+    cache_[rle_hash(c)] = c;
+    color_ = c;
+    return c;
+  }
+
+  constexpr void next_op() {
+    u8 b = *p_++;
+    op_ = b >> 6;
+    if (op_ == op_index) {
+      color_ = cache_[b & 63];
+      left_ = 1;
+    } else {
+      left_ = static_cast<u8>((b & 63) + 1);
+    }
+  }
+
+  const u8* p_;
+  u8 left_ = 0;
+  u8 op_ = op_skip;
+  u16 color_ = 0;
+  u16 cache_[64] = {};
+};
+
+}  // namespace detail
+
+}  // namespace jpico::graphics
@@ -0,0 +1,657 @@
+#pragma once
+#include <cstring>
+#include <span>
+#include <jpico/concepts.hpp>
+#include <jpico/graphics/canvas.hpp>
+#include <jpico/result.hpp>
+#include <jpico/types.hpp>
+
+namespace jpico::graphics {
+
+// output size as a fraction of the image. eighth only decodes dc
+// coefficients and skips the idct entirely.
+enum class jpeg_scale : u8 { full, half, quarter, eighth };
+
+// baseline (sequential huffman) jpeg decoder that streams. input is pulled
+// through a 512 byte buffer from memory or a read callback (a socket, a
+// file), and output is produced one mcu at a time: at most 16 x 16 pixels
+// handed to a callback, so nothing the size of the image is ever held.
+// the whole decoder is about 6 KB; make it static or long-lived rather
+// than putting it on a small stack.
+//
+// supports 8-bit grayscale and ycbcr with 4:4:4, 4:2:2, 4:2:0 and 4:4:0
+// sampling, and restart markers. progressive, arithmetic-coded, 12-bit
+// and cmyk files are rejected by open().
+//
+//   static jpeg_decoder jpeg;
+//   if (jpeg.open(photo_bytes)) draw_jpeg(canvas, 0, 0, jpeg);
+class jpeg_decoder {
+ public:
+  // fill buf with up to n bytes; 0 means end of input
+  using read_fn = usize (*)(void* ctx, u8* buf, usize n);
+
+  // read the headers up to the start of the image data
+  result<void> open(read_fn read, void* ctx) {
+    reset_input();
+    read_ = read;
+    ctx_ = ctx;
+    return parse_headers();
+  }
+
+  result<void> open(std::span<const u8> data) {
+    reset_input();
+    read_ = nullptr;
+    in_ = data.data();
+    in_end_ = data.data() + data.size();
+    return parse_headers();
+  }
+
+  u16 width() const { return width_; }
+  u16 height() const { return height_; }
+
+  u16 width(jpeg_scale s) const { return scaled(width_, s); }
+  u16 height(jpeg_scale s) const { return scaled(height_, s); }
+
+  // decode the image opened last. out(x, y, w, h, pixels) receives each
+  // block of packed rgb565 pixels, left to right and top to bottom, in
+  // output coordinates; blocks on the right and bottom edges are clipped
+  // to the image. one decode per open().
+  template <typename Out>
+  result<void> decode(Out&& out, jpeg_scale scale = jpeg_scale::full) {
+    if (!ready_) return fail(error_code::not_initialized, "jpeg not open");
+    ready_ = false;
+    u8 shift = static_cast<u8>(scale);
+    u8 bs = static_cast<u8>(8 >> shift);  // output block size
+    u16 mcu_w = static_cast<u16>(8 * hmax_);
+    u16 mcu_h = static_cast<u16>(8 * vmax_);
+    u16 mcus_x = static_cast<u16>((width_ + mcu_w - 1) / mcu_w);
+    u16 mcus_y = static_cast<u16>((height_ + mcu_h - 1) / mcu_h);
+    u16 out_w = width(scale), out_h = height(scale);
+    u16 left = restart_interval_;
+    u8 next_rst = 0;
+
+    for (u16 my = 0; my < mcus_y; ++my) {
+      for (u16 mx = 0; mx < mcus_x; ++mx) {
+        if (restart_interval_) {
+          if (!left) {
+            if (!restart(next_rst))
+              return fail(error_code::io_error, "jpeg restart marker missing");
+            next_rst = (next_rst + 1) & 7;
+            left = restart_interval_;
+          }
+          --left;
+        }
+        for (u8 c = 0; c < ncomp_; ++c) {
+          component& k = comp_[c];
+          u8* plane = c == 0 ? plane_y_ : c == 1 ? plane_cb_ : plane_cr_;
+          u8 stride = static_cast<u8>(k.h * bs);
+          for (u8 by = 0; by < k.v; ++by) {
+            for (u8 bx = 0; bx < k.h; ++bx) {
+              if (!decode_block(k, shift))
+                return fail(error_code::io_error, "jpeg data corrupt");
+              put_block(plane + by * bs * stride + bx * bs, stride, k, shift);
+            }
+          }
+        }
+        // fill() pads with zeros once the input runs out; a well-formed
+        // stream only gets there, if at all, within the last mcu
+        if (eof_ && (mx + 1 < mcus_x || my + 1 < mcus_y))
+          return fail(error_code::io_error, "jpeg truncated");
+        u16 x = static_cast<u16>((mx * mcu_w) >> shift);
+        u16 y = static_cast<u16>((my * mcu_h) >> shift);
+        u16 w = static_cast<u16>(mcu_w >> shift);
+        u16 h = static_cast<u16>(mcu_h >> shift);
+        if (x + w > out_w) w = static_cast<u16>(out_w - x);
+        if (y + h > out_h) h = static_cast<u16>(out_h - y);
+        convert(w, h, static_cast<u16>(mcu_w >> shift), shift);
+        out(static_cast<i16>(x), static_cast<i16>(y), w, h, pixels_);
+      }
+    }
+    return ok();
+  }
+
+ private:
+  struct huffman {
+    u16 lookup[256];  // first 8 bits -> length << 8 | symbol, 0 if longer
+    i32 maxcode[18];
+    i32 valoffset[17];
+    u8 symbols[256];
+  };
+
+  struct component {
+    u8 id;
+    u8 h, v;
+    u8 tq;      // quant table
+    u8 td, ta;  // dc and ac huffman tables
+    i16 pred;   // dc predictor
+  };
+
+  static constexpr u8 zigzag[64] = {
+      0,  1,  8,  16, 9,  2,  3,  10, 17, 24, 32, 25, 18, 11, 4,  5,
+      12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13, 6,  7,  14, 21, 28,
+      35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51,
+      58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63};
+
+  static u16 scaled(u16 v, jpeg_scale s) {
+    u8 shift = static_cast<u8>(s);
+    return static_cast<u16>((v + (1 << shift) - 1) >> shift);
+  }
+
+  // input
+
+  void reset_input() {
+    in_ = in_end_ = nullptr;
+    eof_ = false;
+    ready_ = false;
+    bits_ = 0;
+    nbits_ = 0;
+    marker_ = 0;
+    restart_interval_ = 0;
+    ncomp_ = 0;
+  }
+
+  u8 next_byte() {
+    if (in_ == in_end_) {
+      usize n = read_ && !eof_ ? read_(ctx_, buffer_, sizeof(buffer_)) : 0;
+      if (!n) {
+        eof_ = true;
+        return 0;
+      }
+      in_ = buffer_;
+      in_end_ = buffer_ + n;
+    }
+    return *in_++;
+  }
+
+  u16 next_word() {
+    u16 hi = next_byte();
+    return static_cast<u16>(hi << 8 | next_byte());
+  }
+
+  void skip_bytes(u32 n) {
+    while (n--) next_byte();
+  }
+
+  // headers
+
+  result<void> parse_headers() {
+    if (next_byte() != 0xFF || next_byte() != 0xD8)
+      return fail(error_code::invalid_argument, "not a jpeg");
+    bool frame = false;
+    while (!eof_) {
+      u8 m = next_byte();
+      if (m != 0xFF) continue;
+      while (m == 0xFF) m = next_byte();
+      if (m == 0xD8 || (m >= 0xD0 && m <= 0xD7) || m == 0x01) continue;
+      u16 len = next_word();
+      if (len < 2) return fail(error_code::io_error, "jpeg segment too short");
+      len = static_cast<u16>(len - 2);
+      switch (m) {
+        case 0xC0:
+        case 0xC1: {
+          auto r = parse_frame(len);
+          if (!r) return r;
+          frame = true;
+          break;
+        }
+        case 0xC4:
+          if (!parse_huffman(len))
+            return fail(error_code::io_error, "bad jpeg huffman table");
+          break;
+        case 0xDB:
+          if (!parse_quant(len))
+            return fail(error_code::io_error, "bad jpeg quant table");
+          break;
+        case 0xDD:
+          restart_interval_ = next_word();
+          skip_bytes(len - 2u);
+          break;
+        case 0xDA: {
+          if (!frame)
+            return fail(error_code::io_error, "jpeg scan before frame");
+          auto r = parse_scan(len);
+          if (!r) return r;
+          ready_ = true;
+          return ok();
+        }
+        case 0xD9:
+          return fail(error_code::io_error, "jpeg has no image data");
+        default:
+          if ((m >= 0xC2 && m <= 0xCF) && m != 0xC4 && m != 0xC8 && m != 0xCC)
+            return fail(error_code::invalid_argument,
+                        "only baseline jpeg is supported");
+          skip_bytes(len);  // app, comment and the like
+          break;
+      }
+    }
+    return fail(error_code::io_error, "jpeg truncated");
+  }
+
+  result<void> parse_frame(u16 len) {
+    u8 precision = next_byte();
+    height_ = next_word();
+    width_ = next_word();
+    ncomp_ = next_byte();
+    if (precision != 8)
+      return fail(error_code::invalid_argument, "only 8-bit jpeg is supported");
+    if (!width_ || !height_)
+      return fail(error_code::invalid_argument, "jpeg has no size");
+    if (ncomp_ != 1 && ncomp_ != 3)
+      return fail(error_code::invalid_argument,
+                  "jpeg must be grayscale or ycbcr");
+    if (len != 6 + 3 * ncomp_)
+      return fail(error_code::io_error, "bad jpeg frame header");
+    for (u8 i = 0; i < ncomp_; ++i) {
+      component& k = comp_[i];
+      k.id = next_byte();
+      u8 hv = next_byte();
+      k.h = hv >> 4;
+      k.v = hv & 15;
+      k.tq = next_byte() & 3;
+      k.pred = 0;
+    }
+    if (ncomp_ == 1) {
+      // a single-component scan is not interleaved: one block per mcu
+      comp_[0].h = comp_[0].v = 1;
+    } else {
+      for (u8 i = 1; i < 3; ++i) {
+        if (comp_[i].h != 1 || comp_[i].v != 1)
+          return fail(error_code::invalid_argument,
+                      "unsupported jpeg chroma sampling");
+      }
+      if (comp_[0].h < 1 || comp_[0].h > 2 || comp_[0].v < 1 || comp_[0].v > 2)
+        return fail(error_code::invalid_argument,
+                    "unsupported jpeg luma sampling");
+    }
+    hmax_ = comp_[0].h;
+    vmax_ = comp_[0].v;
+    return ok();
+  }
+
+  bool parse_quant(u16 len) {
+    while (len >= 65) {
+      u8 pq = next_byte();
+      u8 id = pq & 3;
+      bool wide = pq >> 4;
+      // check the table fits the segment before reading its entries
+      u16 used = wide ? 129 : 65;
+      if (len < used) return false;
+      for (u8 i = 0; i < 64; ++i)
+        quant_[id][zigzag[i]] = wide ? next_word() : next_byte();
+      len = static_cast<u16>(len - used);
+    }
+    skip_bytes(len);
+    return !eof_;
+  }
+
+  bool parse_huffman(u16 len) {
+    while (len >= 17) {
+      u8 tc = next_byte();
+      huffman& t = huff_[(tc >> 4 ? 2 : 0) + (tc & 1)];
+      u8 counts[17] = {};
+      u16 total = 0;
+      for (u8 l = 1; l <= 16; ++l)
+        total = static_cast<u16>(total + (counts[l] = next_byte()));
+      if (total > 256 || len < 17 + total) return false;
+      for (u16 i = 0; i < total; ++i) t.symbols[i] = next_byte();
+      len = static_cast<u16>(len - 17 - total);
+      if (!build(t, counts)) return false;
+    }
+    skip_bytes(len);
+    return !eof_;
+  }
+
+  // canonical codes from the per-length counts (annex c). false when the
+  // counts ask for more codes of some length than there are.
+  static bool build(huffman& t, const u8* counts) {
+    std::memset(t.lookup, 0, sizeof(t.lookup));
+    i32 code = 0, k = 0;
+    for (u8 l = 1; l <= 16; ++l) {
+      if (code + counts[l] > (1 << l)) return false;
+      t.valoffset[l] = k - code;
+      for (u8 i = 0; i < counts[l]; ++i, ++code, ++k) {
+        if (l > 8) continue;
+        u16 first = static_cast<u16>(code << (8 - l));
+        for (u16 j = 0; j < (1u << (8 - l)); ++j)
+          t.lookup[first + j] = static_cast<u16>(l << 8 | t.symbols[k]);
+      }
+      t.maxcode[l] = code - 1;
+      code <<= 1;
+    }
+    t.maxcode[17] = 0x7FFFFFFF;
+    return true;
+  }
+
+  result<void> parse_scan(u16 len) {
+    u8 n = next_byte();
+    if (n != ncomp_ || len != 4 + 2 * n)
+      return fail(error_code::invalid_argument,
+                  "only single-scan jpeg is supported");
+    for (u8 i = 0; i < n; ++i) {
+      u8 id = next_byte(), t = next_byte();
+      component* k = nullptr;
+      for (u8 j = 0; j < ncomp_; ++j)
+        if (comp_[j].id == id) k = &comp_[j];
+      if (!k) return fail(error_code::io_error, "bad jpeg scan header");
+      k->td = t >> 4 & 1;
+      k->ta = t & 1;
+    }
+    skip_bytes(3);  // spectral selection and approximation: fixed for baseline
+    return eof_ ? fail(error_code::io_error, "jpeg truncated") : ok();
+  }
+
+  // entropy-coded data
+
+  // keep at least 25 bits buffered. after a marker (or the end of input)
+  // zeros are shifted in, which a well-formed stream never reaches.
+  void fill() {
+    while (nbits_ <= 24) {
+      u8 b = 0;
+      if (!marker_) {
+        b = next_byte();
+        if (b == 0xFF) {
+          u8 m = next_byte();
+          while (m == 0xFF) m = next_byte();
+          if (m) {
+            marker_ = m;
+            b = 0;
+          }
+        }
+        if (eof_) marker_ = 0xD9;
+      }
+      bits_ |= static_cast<u32>(b) << (24 - nbits_);
+      nbits_ = static_cast<u8>(nbits_ + 8);
+    }
+  }
+
+  u32 take(u8 n) {
+    u32 v = bits_ >> (32 - n);
+    bits_ <<= n;
+    nbits_ = static_cast<u8>(nbits_ - n);
+    return v;
+  }
+
+  // -1 when no code matches
+  i32 decode_symbol(const huffman& t) {
+    fill();
+    u16 e = t.lookup[bits_ >> 24];
+    if (e) {
+      take(static_cast<u8>(e >> 8));
+      return e & 0xFF;
+    }
+    for (u8 l = 9; l <= 16; ++l) {
+      i32 code = static_cast<i32>(bits_ >> (32 - l));
+      if (code <= t.maxcode[l]) {
+        take(l);
+        return t.symbols[(code + t.valoffset[l]) & 0xFF];
+      }
+    }
+    return -1;
+  }
+
+  // s-bit magnitude category value (f.2.2.1)
+  i32 receive(u8 s) {
+    if (!s) return 0;
+    fill();
+    i32 v = static_cast<i32>(take(s));
+    return v < (1 << (s - 1)) ? v - (1 << s) + 1 : v;
+  }
+
+  // at a restart: drop the partial byte, expect RSTn, reset predictors
+  bool restart(u8 n) {
+    bits_ = 0;
+    nbits_ = 0;
+    if (!marker_) {
+      // the marker follows the data; scan for it
+      u8 b = next_byte();
+      while (!eof_) {
+        if (b == 0xFF) {
+          u8 m = next_byte();
+          while (m == 0xFF) m = next_byte();
+          if (m) {
+            marker_ = m;
+            break;
+          }
+        }
+        b = next_byte();
+      }
+    }
+    bool ok = marker_ == 0xD0 + n;
+    marker_ = 0;
+    for (u8 c = 0; c < ncomp_; ++c) comp_[c].pred = 0;
+    return ok;
+  }
+
+  // huffman-decode one block into coef_ (natural order, quantized). only
+  // the dc term is kept when scaling to 1/8.
+  bool decode_block(component& k, u8 shift) {
+    i32 t = decode_symbol(huff_[k.td]);
+    if (t < 0 || t > 11) return false;
+    k.pred = static_cast<i16>(k.pred + receive(static_cast<u8>(t)));
+    std::memset(coef_, 0, sizeof(coef_));
+    coef_[0] = k.pred;
+    const huffman& ac = huff_[2 + k.ta];
+    for (u8 i = 1; i < 64;) {
+      i32 rs = decode_symbol(ac);
+      if (rs < 0) return false;
+      u8 r = static_cast<u8>(rs >> 4), s = static_cast<u8>(rs & 15);
+      if (!s) {
+        if (r != 15) break;  // end of block
+        i += 16;
+        continue;
+      }
+      i = static_cast<u8>(i + r);
+      if (i > 63 || s > 10) return false;  // baseline ac values fit 10 bits
+      i32 v = receive(s);
+      if (shift < 3) coef_[zigzag[i]] = static_cast<i16>(v);
+      ++i;
+    }
+    return true;
+  }
+
+  // pixels
+
+  static u8 clamp8(i32 v) {
+    return static_cast<u8>(v < 0 ? 0 : v > 255 ? 255 : v);
+  }
+
+  // 8-bit samples keep dequantized coefficients within +-1024. corrupt
+  // data is clamped to that, which keeps the idct's i32 math in range.
+  static i32 dequant(i16 v, u16 q) {
+    i32 d = v * q;
+    return d < -1024 ? -1024 : d > 1024 ? 1024 : d;
+  }
+
+  // dequantize, inverse transform and write the block at dst, reduced to
+  // 8 >> shift pixels square
+  void put_block(u8* dst, u8 stride, const component& k, u8 shift) {
+    const u16* q = quant_[k.tq];
+    if (shift == 3) {
+      *dst = clamp8(((dequant(coef_[0], q[0]) + 4) >> 3) + 128);
+      return;
+    }
+    u8 px[64];
+    idct(q, px);
+    u8 f = static_cast<u8>(1 << shift), bs = static_cast<u8>(8 >> shift);
+    for (u8 y = 0; y < bs; ++y) {
+      for (u8 x = 0; x < bs; ++x) {
+        u32 sum = 0;
+        for (u8 j = 0; j < f; ++j)
+          for (u8 i = 0; i < f; ++i) sum += px[(y * f + j) * 8 + x * f + i];
+        dst[y * stride + x] = static_cast<u8>((sum + f * f / 2) >> (2 * shift));
+      }
+    }
+  }
+
+  // integer islow idct (loeffler, ligtenberg, moschytz) as in the ijg
+  // reference: 13-bit constants, two passes, columns first
+  void idct(const u16* q, u8* out) const {
+    constexpr i32 c0_298 = 2446, c0_390 = 3196, c0_541 = 4433,
+                  c0_765 = 6270, c0_899 = 7373, c1_175 = 9633,
+                  c1_501 = 12299, c1_847 = 15137, c1_961 = 16069,
+                  c2_053 = 16819, c2_562 = 20995, c3_072 = 25172;
+    constexpr u8 bits = 13, pass1 = 2;
+    i32 ws[64];
+
+    for (u8 c = 0; c < 8; ++c) {
+      const i16* in = coef_ + c;
+      const u16* qc = q + c;
+      i32* w = ws + c;
+      if (!in[8] && !in[16] && !in[24] && !in[32] && !in[40] && !in[48] &&
+          !in[56]) {
+        i32 dc = dequant(in[0], qc[0]) * (1 << pass1);
+        for (u8 r = 0; r < 8; ++r) w[r * 8] = dc;
+        continue;
+      }
+      i32 z2 = dequant(in[16], qc[16]), z3 = dequant(in[48], qc[48]);
+      i32 z1 = (z2 + z3) * c0_541;
+      i32 t2 = z1 - z3 * c1_847;
+      i32 t3 = z1 + z2 * c0_765;
+      z2 = dequant(in[0], qc[0]);
+      z3 = dequant(in[32], qc[32]);
+      i32 t0 = (z2 + z3) * (1 << bits);
+      i32 t1 = (z2 - z3) * (1 << bits);
+      i32 t10 = t0 + t3, t13 = t0 - t3, t11 = t1 + t2, t12 = t1 - t2;
+
+      t0 = dequant(in[56], qc[56]);
+      t1 = dequant(in[40], qc[40]);
+      t2 = dequant(in[24], qc[24]);
+      t3 = dequant(in[8], qc[8]);
+      odd(t0, t1, t2, t3, c0_298, c0_390, c0_899, c1_175, c1_501, c1_961,
+          c2_053, c2_562, c3_072);
+      constexpr u8 d = bits - pass1;
+      constexpr i32 half = 1 << (d - 1);
+      w[0] = (t10 + t3 + half) >> d;
+      w[56] = (t10 - t3 + half) >> d;
+      w[8] = (t11 + t2 + half) >> d;
+      w[48] = (t11 - t2 + half) >> d;
+      w[16] = (t12 + t1 + half) >> d;
+      w[40] = (t12 - t1 + half) >> d;
+      w[24] = (t13 + t0 + half) >> d;
+      w[32] = (t13 - t0 + half) >> d;
+    }
+
+    for (u8 r = 0; r < 8; ++r) {
+      const i32* w = ws + r * 8;
+      u8* o = out + r * 8;
+      constexpr u8 d = bits + pass1 + 3;
+      constexpr i32 half = 1 << (d - 1);
+      if (!w[1] && !w[2] && !w[3] && !w[4] && !w[5] && !w[6] && !w[7]) {
+        u8 v = clamp8(((w[0] + (1 << (pass1 + 2))) >> (pass1 + 3)) + 128);
+        std::memset(o, v, 8);
+        continue;
+      }
+      i32 z2 = w[2], z3 = w[6];
+      i32 z1 = (z2 + z3) * c0_541;
+      i32 t2 = z1 - z3 * c1_847;
+      i32 t3 = z1 + z2 * c0_765;
+      i32 t0 = (w[0] + w[4]) * (1 << bits);
+      i32 t1 = (w[0] - w[4]) * (1 << bits);
+      i32 t10 = t0 + t3, t13 = t0 - t3, t11 = t1 + t2, t12 = t1 - t2;
+
+      t0 = w[7];
+      t1 = w[5];
+      t2 = w[3];
+      t3 = w[1];
+      odd(t0, t1, t2, t3, c0_298, c0_390, c0_899, c1_175, c1_501, c1_961,
+          c2_053, c2_562, c3_072);
+      o[0] = clamp8(((t10 + t3 + half) >> d) + 128);
+      o[7] = clamp8(((t10 - t3 + half) >> d) + 128);
+      o[1] = clamp8(((t11 + t2 + half) >> d) + 128);
+      o[6] = clamp8(((t11 - t2 + half) >> d) + 128);
+      o[2] = clamp8(((t12 + t1 + half) >> d) + 128);
+      o[5] = clamp8(((t12 - t1 + half) >> d) + 128);
+      o[3] = clamp8(((t13 + t0 + half) >> d) + 128);
+      o[4] = clamp8(((t13 - t0 + half) >> d) + 128);
+    }
+  }
+
+  // odd half of the 8-point idct, shared by both passes. inputs are the
+  // coefficients 7, 5, 3, 1; outputs replace them in the same order.
+  static void odd(i32& t0, i32& t1, i32& t2, i32& t3, i32 c0_298, i32 c0_390,
+                  i32 c0_899, i32 c1_175, i32 c1_501, i32 c1_961, i32 c2_053,
+                  i32 c2_562, i32 c3_072) {
+    i32 z1 = t0 + t3, z2 = t1 + t2, z3 = t0 + t2, z4 = t1 + t3;
+    i32 z5 = (z3 + z4) * c1_175;
+    t0 *= c0_298;
+    t1 *= c2_053;
+    t2 *= c3_072;
+    t3 *= c1_501;
+    z1 *= -c0_899;
+    z2 *= -c2_562;
+    z3 = z3 * -c1_961 + z5;
+    z4 = z4 * -c0_390 + z5;
+    t0 += z1 + z3;
+    t1 += z2 + z4;
+    t2 += z2 + z3;
+    t3 += z1 + z4;
+  }
+
+  // mcu planes to rgb565. chroma is replicated over the luma samples it
+  // covers.
+  void convert(u16 w, u16 h, u16 stride, u8 shift) {
+    u8 hs = hmax_ == 2, vs = vmax_ == 2;
+    u8 cstride = static_cast<u8>(8 >> shift);
+    u16* dst = pixels_;
+    for (u16 y = 0; y < h; ++y) {
+      const u8* ys = plane_y_ + y * stride;
+      for (u16 x = 0; x < w; ++x) {
+        i32 l = ys[x];
+        if (ncomp_ == 1) {
+          *dst++ = static_cast<u16>((l >> 3) << 11 | (l >> 2) << 5 | l >> 3);
+          continue;
+        }
+        u16 ci = static_cast<u16>((y >> vs) * cstride + (x >> hs));
+        i32 cb = plane_cb_[ci] - 128, cr = plane_cr_[ci] - 128;
+        // bt.601 full range, 16-bit fixed point
+        i32 r = l + ((91881 * cr + 32768) >> 16);
+        i32 g = l - ((22554 * cb + 46802 * cr - 32768) >> 16);
+        i32 b = l + ((116130 * cb + 32768) >> 16);
+        *dst++ = static_cast<u16>((clamp8(r) >> 3) << 11 |
+                                  (clamp8(g) >> 2) << 5 | clamp8(b) >> 3);
+      }
+    }
+  }
+
+  read_fn read_ = nullptr;
+  void* ctx_ = nullptr;
+  const u8* in_ = nullptr;
+  const u8* in_end_ = nullptr;
+  bool eof_ = false;
+  bool ready_ = false;
+
+  u32 bits_ = 0;
+  u8 nbits_ = 0;
+  u8 marker_ = 0;  // marker met inside the entropy-coded data
+
+  u16 width_ = 0, height_ = 0;
+  u16 restart_interval_ = 0;
+  u8 ncomp_ = 0;
+  u8 hmax_ = 1, vmax_ = 1;
+  component comp_[3] = {};
+
+  u16 quant_[4][64] = {};
+  huffman huff_[4] = {};  // dc0, dc1, ac0, ac1
+  i16 coef_[64] = {};
+  u8 plane_y_[256] = {};
+  u8 plane_cb_[64] = {};
+  u8 plane_cr_[64] = {};
+  u16 pixels_[256] = {};
+  u8 buffer_[512] = {};
+};
+
+// decode the open image onto the canvas with its top-left at (x, y). each
+// mcu goes through draw_image: into the framebuffer, or straight to the
+// display as one blit when there is none.
+template <display D, typename S>
+result<void> draw_jpeg(canvas<D, S>& c, i16 x, i16 y, jpeg_decoder& jpeg,
+                       jpeg_scale scale = jpeg_scale::full) {
+  return jpeg.decode(
+      [&](i16 bx, i16 by, u16 w, u16 h, const u16* pixels) {
+        c.draw_image(static_cast<i16>(x + bx), static_cast<i16>(y + by), w, h,
+                     pixels);
+      },
+      scale);
+}
+
+}  // namespace jpico::graphics
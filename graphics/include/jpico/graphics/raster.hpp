@@ -0,0 +1,400 @@
+#pragma once
+#include <algorithm>
+#include <jpico/types.hpp>
+
+namespace jpico::graphics {
+
+enum class fill_rule : u8 { even_odd, non_zero };
+
+// subpixel vertex in 1/16 pixel units. (0, 0) is the top-left corner of
+// pixel (0, 0); its center is (8, 8).
+struct point_fx {
+  static constexpr i32 one = 16;
+
+  i32 x = 0;
+  i32 y = 0;
+
+  constexpr bool operator==(const point_fx&) const = default;
+
+  // integer vertices sit on pixel centers
+  static constexpr point_fx from(point p) {
+    return {p.x * one + one / 2, p.y * one + one / 2};
+  }
+};
+
+inline constexpr usize max_polygon_points = 64;
+
+constexpr u32 isqrt(u64 v) {
+  u64 r = 0, bit = u64{1} << 62;
+  while (bit > v) bit >>= 2;
+  while (bit) {
+    if (v >= r + bit) {
+      v -= r + bit;
+      r = (r >> 1) + bit;
+    } else {
+      r >>= 1;
+    }
+    bit >>= 2;
+  }
+  return static_cast<u32>(r);
+}
+
+namespace detail {
+
+inline constexpr i16 sin_q14[91] = {
+    0,     286,   572,   857,   1143,  1428,  1713,  1997,  2280,  2563,
+    2845,  3126,  3406,  3686,  3964,  4240,  4516,  4790,  5063,  5334,
+    5604,  5872,  6138,  6402,  6664,  6924,  7182,  7438,  7692,  7943,
+    8192,  8438,  8682,  8923,  9162,  9397,  9630,  9860,  10087, 10311,
+    10531, 10749, 10963, 11174, 11381, 11585, 11786, 11982, 12176, 12365,
+    12551, 12733, 12911, 13085, 13255, 13421, 13583, 13741, 13894, 14044,
+    14189, 14330, 14466, 14598, 14726, 14849, 14968, 15082, 15191, 15296,
+    15396, 15491, 15582, 15668, 15749, 15826, 15897, 15964, 16026, 16083,
+    16135, 16182, 16225, 16262, 16294, 16322, 16344, 16362, 16374, 16382,
+    16384,
+};
+
+// floor(a / b), b != 0
+constexpr i32 floor_div(i32 a, i32 b) {
+  i32 q = a / b;
+  return (a % b != 0 && ((a < 0) != (b < 0))) ? q - 1 : q;
+}
+
+// inclusive integer interval, empty when lo > hi
+struct interval {
+  i32 lo, hi;
+};
+
+inline constexpr i32 unbounded = 1 << 30;
+
+// {dx : a * dx <= b}
+constexpr interval half_line(i32 a, i32 b) {
+  if (a > 0) return {-unbounded, floor_div(b, a)};
+  if (a < 0) return {-floor_div(b, -a), unbounded};
+  return b >= 0 ? interval{-unbounded, unbounded} : interval{1, 0};
+}
+
+}  // namespace detail
+
+// integer degrees, Q14 (16384 = 1.0)
+constexpr i32 isin(i32 deg) {
+  deg %= 360;
+  if (deg < 0) deg += 360;
+  if (deg <= 90) return detail::sin_q14[deg];
+  if (deg <= 180) return detail::sin_q14[180 - deg];
+  if (deg <= 270) return -detail::sin_q14[deg - 180];
+  return -detail::sin_q14[360 - deg];
+}
+
+constexpr i32 icos(i32 deg) { return isin(deg + 90); }
+
+// ring segment (r_inner > 0) or pie slice (r_inner == 0) centered on pixel
+// (cx, cy). radii are inclusive pixel distances. angles are degrees, 0 at
+// 3 o'clock and increasing clockwise; the segment runs clockwise from start
+// to end, and a sweep of 360 or more is a full ring.
+template <typename Emit>
+void rasterize_arc(i16 cx, i16 cy, u16 r_outer, u16 r_inner, i32 start,
+                   i32 end, rect clip, Emit&& emit) {
+  using detail::interval;
+  if (r_inner > r_outer) return;
+
+  i32 sweep = end - start;
+  bool full = sweep >= 360 || sweep <= -360;
+  sweep = ((sweep % 360) + 360) % 360;
+  if (!full && sweep == 0) return;
+
+  i32 sx = icos(start), sy = isin(start);
+  i32 ex = icos(end), ey = isin(end);
+
+  i32 ro = r_outer, ri = r_inner;
+  i32 y0 = std::max<i32>(cy - ro, clip.y());
+  i32 y1 = std::min<i32>(cy + ro + 1, clip.bottom());
+  i32 lo = clip.x() - cx, hi = clip.right() - 1 - cx;
+
+  for (i32 y = y0; y < y1; ++y) {
+    i32 dy = y - cy;
+    // radii cover [r - 0.5, r + 0.5], matching the midpoint circle
+    i32 xo = static_cast<i32>(isqrt(static_cast<u64>(ro * ro + ro - dy * dy)));
+    i32 in = ri * ri - ri - dy * dy;
+    i32 xi = 0;
+    if (ri > 0 && in > 0) {
+      xi = static_cast<i32>(isqrt(static_cast<u64>(in)));
+      if (xi * xi < in) ++xi;
+    }
+
+    interval ring[2];
+    usize n_ring = 0;
+    if (xi == 0) {
+      ring[n_ring++] = {-xo, xo};
+    } else {
+      ring[n_ring++] = {-xo, -xi};
+      ring[n_ring++] = {xi, xo};
+    }
+
+    // angular window as up to two sorted, disjoint intervals
+    interval allowed[2];
+    usize n_allowed = 0;
+    if (full) {
+      allowed[n_allowed++] = {-detail::unbounded, detail::unbounded};
+    } else {
+      // cross(start, p) >= 0 and cross(p, end) >= 0
+      interval a = detail::half_line(sy, sx * dy);
+      interval b = detail::half_line(-ey, -ex * dy);
+      if (sweep <= 180) {
+        allowed[n_allowed++] = {std::max(a.lo, b.lo), std::min(a.hi, b.hi)};
+      } else {
+        if (a.lo > b.lo || (a.lo == b.lo && a.hi < b.hi)) std::swap(a, b);
+        if (a.lo > a.hi) {
+          allowed[n_allowed++] = b;
+        } else if (b.lo > b.hi) {
+          allowed[n_allowed++] = a;
+        } else if (b.lo <= a.hi + 1) {
+          allowed[n_allowed++] = {a.lo, std::max(a.hi, b.hi)};
+        } else {
+          allowed[n_allowed++] = a;
+          allowed[n_allowed++] = b;
+        }
+      }
+    }
+
+    for (usize i = 0; i < n_ring; ++i) {
+      for (usize j = 0; j < n_allowed; ++j) {
+        i32 a = std::max({ring[i].lo, allowed[j].lo, lo});
+        i32 b = std::min({ring[i].hi, allowed[j].hi, hi});
+        if (a <= b) {
+          emit(static_cast<i16>(y), static_cast<i16>(cx + a),
+               static_cast<i16>(cx + b + 1));
+        }
+      }
+    }
+  }
+}
+
+// rounded rectangle with corner radius r. thickness 0 fills it, otherwise
+// only a border of that many pixels is emitted.
+template <typename Emit>
+void rasterize_round_rect(rect box, u16 radius, u16 thickness, rect clip,
+                          Emit&& emit) {
+  i32 w = box.width(), h = box.height();
+  if (w <= 0 || h <= 0) return;
+  i32 r = std::min<i32>(radius, std::min(w, h) / 2);
+  i32 t = thickness;
+
+  // columns cut off at row j of a w x h box with corner radius rr
+  auto inset = [](i32 j, i32 h, i32 rr) {
+    i32 dy = j < rr ? rr - j : (j >= h - rr ? j - (h - 1 - rr) : 0);
+    if (!dy) return 0;
+    return rr - static_cast<i32>(isqrt(static_cast<u64>(rr * rr + rr - dy * dy)));
+  };
+
+  bool hollow = t > 0 && 2 * t < w && 2 * t < h;
+  i32 ri = std::max<i32>(r - t, 0);
+  i32 y0 = std::max<i32>(box.y(), clip.y());
+  i32 y1 = std::min<i32>(box.bottom(), clip.bottom());
+  i32 lo = clip.x(), hi = clip.right();
+
+  auto put = [&](i32 y, i32 a, i32 b) {
+    a = std::max(a, lo);
+    b = std::min(b, hi);
+    if (a < b) emit(static_cast<i16>(y), static_cast<i16>(a), static_cast<i16>(b));
+  };
+
+  for (i32 y = y0; y < y1; ++y) {
+    i32 j = y - box.y();
+    i32 d = inset(j, h, r);
+    i32 a = box.x() + d, b = box.x() + w - d;
+    i32 ij = j - t;
+    if (!hollow || ij < 0 || ij >= h - 2 * t) {
+      put(y, a, b);
+      continue;
+    }
+    i32 id = inset(ij, h - 2 * t, ri);
+    put(y, a, box.x() + t + id);
+    put(y, box.x() + w - t - id, b);
+  }
+}
+
+enum class line_cap : u8 { butt, square, round };
+
+inline constexpr usize max_stroke_points = 36;
+
+// outline of a `width`-pixel stroke from a to b as a convex polygon, for
+// rasterize_polygon. returns the number of points written to out, which
+// must hold max_stroke_points.
+inline usize stroke_outline(point_fx a, point_fx b, i32 width, line_cap cap,
+                            point_fx* out) {
+  i32 dx = b.x - a.x, dy = b.y - a.y;
+  i32 len = static_cast<i32>(
+      isqrt(static_cast<u64>(static_cast<i64>(dx) * dx + static_cast<i64>(dy) * dy)));
+  i32 half = width * point_fx::one / 2;
+  if (len == 0) {
+    // degenerate: a dot, drawn as a square or round blob
+    dx = point_fx::one;
+    dy = 0;
+    len = point_fx::one;
+    if (cap == line_cap::butt) cap = line_cap::square;
+  }
+
+  // unit direction and normal scaled to half the width
+  i32 ux = static_cast<i32>(static_cast<i64>(dx) * half / len);
+  i32 uy = static_cast<i32>(static_cast<i64>(dy) * half / len);
+  i32 nx = -uy, ny = ux;
+
+  usize n = 0;
+  if (cap != line_cap::round) {
+    i32 ex = cap == line_cap::square ? ux : 0;
+    i32 ey = cap == line_cap::square ? uy : 0;
+    out[n++] = {a.x - ex + nx, a.y - ey + ny};
+    out[n++] = {b.x + ex + nx, b.y + ey + ny};
+    out[n++] = {b.x + ex - nx, b.y + ey - ny};
+    out[n++] = {a.x - ex - nx, a.y - ey - ny};
+    return n;
+  }
+
+  // half-circle fans around each end, more segments for fatter lines
+  i32 segs = std::clamp<i32>(width / 2, 4, (max_stroke_points - 2) / 2);
+  auto fan = [&](point_fx c, i32 sign) {
+    for (i32 k = 0; k <= segs; ++k) {
+      i32 deg = k * 180 / segs;
+      i32 co = icos(deg), si = isin(deg);
+      // sweep from +normal through the cap direction to -normal
+      out[n++] = {c.x + static_cast<i32>((static_cast<i64>(nx) * co +
+                                          static_cast<i64>(sign * ux) * si) >> 14),
+                  c.y + static_cast<i32>((static_cast<i64>(ny) * co +
+                                          static_cast<i64>(sign * uy) * si) >> 14)};
+    }
+  };
+  fan(b, 1);
+  nx = -nx;
+  ny = -ny;
+  fan(a, -1);
+  return n;
+}
+
+constexpr point_fx to_fx(point_fx p) { return p; }
+constexpr point_fx to_fx(point p) { return point_fx::from(p); }
+
+namespace detail {
+
+// rasterize_polygon with room for up to N edges
+template <usize N, typename P, typename Emit>
+void scan_polygon(const P* pts, usize n, fill_rule rule, rect clip,
+                  Emit& emit) {
+  static_assert(N <= 256, "active edges are kept as u8 indices");
+
+  // x is tracked in 20.12 pixel units, stepped once per row. the vertices
+  // stay in pts; an edge only keeps where it starts.
+  struct edge {
+    i32 x;       // at the current row, 20.12
+    i32 step;    // per row, 20.12
+    i16 r0, r1;  // rows covered within the clip, [r0, r1)
+    u8 top;      // index of the upper vertex
+    i8 dir;      // +1 when pts runs downward along the edge
+  };
+  edge edges[N];
+  usize count = 0;
+
+  i32 top = clip.y(), bottom = clip.bottom();
+  i32 r_min = bottom, r_max = top;
+  for (usize i = 0; i < n; ++i) {
+    usize j = i + 1 == n ? 0 : i + 1;
+    point_fx a = to_fx(pts[i]), b = to_fx(pts[j]);
+    i8 dir = 1;
+    if (a.y > b.y) {
+      std::swap(a, b);
+      dir = -1;
+    }
+    i32 r0 = std::max((a.y + 7) >> 4, top);
+    i32 r1 = std::min((b.y + 7) >> 4, bottom);
+    if (r0 >= r1) continue;
+    i32 step = static_cast<i32>((static_cast<i64>(b.x - a.x) << 12) /
+                                (b.y - a.y));
+    r_min = std::min(r_min, r0);
+    r_max = std::max(r_max, r1);
+    edges[count++] = {0, step, static_cast<i16>(r0), static_cast<i16>(r1),
+                      static_cast<u8>(dir > 0 ? i : j), dir};
+  }
+  if (r_min >= r_max) return;
+
+  std::sort(edges, edges + count,
+            [](const edge& a, const edge& b) { return a.r0 < b.r0; });
+
+  u8 active[N];
+  usize n_active = 0, next = 0;
+  i32 x_lo = clip.x(), x_hi = clip.right();
+
+  for (i32 r = r_min; r < r_max; ++r) {
+    // retire finished edges, step the rest
+    usize k = 0;
+    for (usize i = 0; i < n_active; ++i) {
+      edge& e = edges[active[i]];
+      if (e.r1 > r) {
+        e.x += e.step;
+        active[k++] = active[i];
+      }
+    }
+    n_active = k;
+
+    // new edges start at their exact intersection with this row
+    while (next < count && edges[next].r0 <= r) {
+      edge& e = edges[next];
+      usize other = e.dir > 0 ? (e.top + 1u == n ? 0 : e.top + 1u)
+                              : (e.top ? e.top - 1u : n - 1);
+      point_fx a = to_fx(pts[e.top]), b = to_fx(pts[other]);
+      i64 ys = r * point_fx::one + point_fx::one / 2 - a.y;
+      e.x = static_cast<i32>((static_cast<i64>(a.x) << 8) +
+                             ((ys * (b.x - a.x)) << 8) / (b.y - a.y));
+      active[n_active++] = static_cast<u8>(next++);
+    }
+
+    // few crossings per row and nearly sorted from the last: insertion sort
+    for (usize i = 1; i < n_active; ++i) {
+      u8 e = active[i];
+      usize j = i;
+      for (; j > 0 && edges[active[j - 1]].x > edges[e].x; --j)
+        active[j] = active[j - 1];
+      active[j] = e;
+    }
+
+    // walk the crossings, merging everything between enter and leave
+    i32 winding = 0, start = 0;
+    for (usize i = 0; i < n_active; ++i) {
+      const edge& e = edges[active[i]];
+      bool was = rule == fill_rule::even_odd ? (winding & 1) : winding != 0;
+      winding += rule == fill_rule::even_odd ? 1 : e.dir;
+      bool now = rule == fill_rule::even_odd ? (winding & 1) : winding != 0;
+      if (now == was) continue;
+      if (now) {
+        start = e.x;
+        continue;
+      }
+      // first and last pixel centers inside [start, x)
+      i32 x0 = std::max((start + 2047) >> 12, x_lo);
+      i32 x1 = std::min((e.x + 2047) >> 12, x_hi);
+      if (x0 < x1) {
+        emit(static_cast<i16>(r), static_cast<i16>(x0), static_cast<i16>(x1));
+      }
+    }
+  }
+}
+
+}  // namespace detail
+
+// edge-table scanline rasterizer. covers every pixel whose center is inside
+// the polygon (edges shared by adjacent polygons are drawn once) and calls
+// emit(y, x0, x1) for each covered span [x0, x1) inside `clip`. vertices
+// are point or point_fx; polygons with more than max_polygon_points are
+// not drawn. the edge table is 12 bytes an edge, sized for four (triangles,
+// thick lines without round caps) or for max_polygon_points.
+template <typename P, typename Emit>
+void rasterize_polygon(const P* pts, usize n, fill_rule rule, rect clip,
+                       Emit&& emit) {
+  if (n < 3 || n > max_polygon_points) return;
+  if (n <= 4) {
+    detail::scan_polygon<4>(pts, n, rule, clip, emit);
+  } else {
+    detail::scan_polygon<max_polygon_points>(pts, n, rule, clip, emit);
+  }
+}
+
+}  // namespace jpico::graphics
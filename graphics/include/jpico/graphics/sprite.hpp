@@ -0,0 +1,142 @@
+#pragma once
+#include <jpico/graphics/canvas.hpp>
+#include <jpico/graphics/damage.hpp>
+#include <jpico/graphics/image.hpp>
+#include <jpico/result.hpp>
+#include <jpico/types.hpp>
+
+namespace jpico::graphics {
+
+struct sprite {
+  const image* img = nullptr;
+  point pos;
+  i16 z = 0;
+  u8 alpha = 255;  // on top of the image's own alpha channel
+  bool visible = true;
+
+  constexpr jpico::rect bounds() const { return {pos, {img->w, img->h}}; }
+};
+
+// fixed pool of up to N sprites over a caller-drawn background. changes
+// only record damaged rects; compose() repaints just those, background
+// first and then every visible sprite intersecting them from low to high
+// z (ties in insertion order), each clipped to the damage. overlapping
+// damage is merged (see damage_list).
+template <usize N, usize MaxDamage = 8>
+class sprite_layer {
+  static_assert(N <= 255, "sprite ids are u8");
+
+ public:
+  result<u8> add(const image& img, point pos, i16 z = 0, u8 alpha = 255) {
+    for (u8 id = 0; id < N; ++id) {
+      if (sprites_[id].img) continue;
+      sprites_[id] = {&img, pos, z, alpha, true};
+      insert(id);
+      damage(sprites_[id].bounds());
+      return id;
+    }
+    return fail(error_code::out_of_memory, "sprite layer full");
+  }
+
+  void remove(u8 id) {
+    damage(visible_bounds(id));
+    unlink(id);
+    sprites_[id].img = nullptr;
+  }
+
+  void move(u8 id, point pos) {
+    if (sprites_[id].pos == pos) return;
+    damage(visible_bounds(id));
+    sprites_[id].pos = pos;
+    damage(visible_bounds(id));
+  }
+
+  void set_image(u8 id, const image& img) {
+    damage(visible_bounds(id));
+    sprites_[id].img = &img;
+    damage(visible_bounds(id));
+  }
+
+  void set_z(u8 id, i16 z) {
+    if (sprites_[id].z == z) return;
+    unlink(id);
+    sprites_[id].z = z;
+    insert(id);
+    damage(visible_bounds(id));
+  }
+
+  void set_alpha(u8 id, u8 alpha) {
+    if (sprites_[id].alpha == alpha) return;
+    sprites_[id].alpha = alpha;
+    damage(visible_bounds(id));
+  }
+
+  void show(u8 id, bool visible) {
+    if (sprites_[id].visible == visible) return;
+    damage(sprites_[id].bounds());
+    sprites_[id].visible = visible;
+  }
+
+  const sprite& operator[](u8 id) const { return sprites_[id]; }
+  u8 count() const { return count_; }
+
+  // mark a region for repaint, e.g. after the background changed under it
+  void damage(jpico::rect r) { damage_.add(r); }
+
+  bool dirty() const { return !damage_.empty(); }
+
+  // background(canvas, rect) must repaint the rect; it runs with the clip
+  // already narrowed to it. returns the bounding box of everything
+  // repainted, for flush_rows(), and clears the damage. with the clip
+  // stack already full nothing is drawn: the damage is kept and the
+  // returned rect is empty.
+  template <display D, typename S, typename Background>
+  jpico::rect compose(canvas<D, S>& c, Background&& background) {
+    for (const jpico::rect& d : damage_) {
+      // the depth is the same for every rect, so only the first can fail
+      if (!c.push_clip(d)) return {};
+      background(c, d);
+      for (u8 k = 0; k < count_; ++k) {
+        const sprite& s = sprites_[order_[k]];
+        if (s.visible && s.bounds().intersects(d)) {
+          c.draw_image(s.pos.x, s.pos.y, *s.img, s.alpha);
+        }
+      }
+      c.pop_clip();
+    }
+    jpico::rect painted = damage_.bounds();
+    damage_.clear();
+    return painted;
+  }
+
+ private:
+  jpico::rect visible_bounds(u8 id) const {
+    const sprite& s = sprites_[id];
+    return s.visible ? s.bounds() : jpico::rect{};
+  }
+
+  // keep order_ sorted by z; equal z keeps insertion order
+  void insert(u8 id) {
+    u8 k = count_;
+    while (k > 0 && sprites_[order_[k - 1]].z > sprites_[id].z) {
+      order_[k] = order_[k - 1];
+      --k;
+    }
+    order_[k] = id;
+    ++count_;
+  }
+
+  void unlink(u8 id) {
+    u8 k = 0;
+    while (k < count_ && order_[k] != id) ++k;
+    if (k == count_) return;
+    for (--count_; k < count_; ++k) order_[k] = order_[k + 1];
+  }
+
+  sprite sprites_[N] = {};
+  u8 order_[N] = {};
+  u8 count_ = 0;
+  damage_list<MaxDamage> damage_;
+};
+
+}  // namespace jpico::graphics
@@ -0,0 +1,63 @@
+#pragma once
+#include <jpico/color.hpp>
+#include <jpico/format.hpp>
+#include <jpico/graphics/canvas.hpp>
+#include <jpico/stats.hpp>
+
+namespace jpico::graphics {
+
+// two lines of the canvas's last frame stats in the builtin font:
+//
+//   42 fps  draw 11.2ms  flush 12.6ms
+//   blit 9 px 0 dirty 76800 bus 153618B
+//
+// bus is the traffic on the given bus since the previous draw(), so draw
+// once per frame. drawn into the frame it describes the one before; the
+// overlay's own pixels are counted too. draws nothing without JPICO_STATS.
+class stats_overlay {
+ public:
+  explicit stats_overlay(const bus_stats* bus = nullptr) : bus_{bus} {}
+
+  // the longest line, the second with every counter at 10 digits, is 62
+  // characters. the whole area is cleared each draw, clipped to the canvas
+  static constexpr u16 max_chars = 62;
+  static constexpr u16 width = max_chars * 6;
+  static constexpr u16 height = 2 * 8;
+
+  template <display D, typename S>
+  void draw(canvas<D, S>& c, i16 x, i16 y, u16 fg = colors::white.raw,
+            u16 bg = colors::black.raw) {
+    if constexpr (stats_enabled) {
+      const frame_stats& f = c.last_frame_stats();
+      u32 bytes = bus_ ? bus_->bytes - last_bytes_ : 0;
+      if (bus_) last_bytes_ = bus_->bytes;
+
+      const font* face = c.current_text_style().face;
+      c.set_font(nullptr);
+      c.fill_rect(x, y, width, height, bg);
+      char buf[max_chars + 1];
+      buffer_sink out{buf};
+      format_to(out, "{} fps  draw {}ms  flush {}ms", f.fps(),
+                decimal{static_cast<i32>(f.raster_us / 100), 1},
+                decimal{static_cast<i32>(f.flush_us / 100), 1});
+      line(c, x, y, buf, fg, bg);
+      out = buffer_sink{buf};
+      format_to(out, "blit {} px {} dirty {} bus {}B", f.blits, f.pixel_calls,
+                f.dirty_area, bytes);
+      line(c, x, static_cast<i16>(y + 8), buf, fg, bg);
+      c.set_font(face);
+    }
+  }
+
+ private:
+  template <typename Canvas>
+  static void line(Canvas& c, i16 x, i16 y, const char* s, u16 fg, u16 bg) {
+    for (; *s && x < c.width(); ++s, x = static_cast<i16>(x + 6))
+      c.draw_char(x, y, *s, fg, bg);
+  }
+
+  const bus_stats* bus_;
+  u32 last_bytes_ = 0;
+};
+
+}  // namespace jpico::graphics
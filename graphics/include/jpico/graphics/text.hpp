@@ -0,0 +1,194 @@
+#pragma once
+#include <span>
+#include <jpico/graphics/font.hpp>
+#include <jpico/types.hpp>
+
+namespace jpico::graphics {
+
+enum class text_align : u8 { left, center, right };
+enum class text_valign : u8 { top, middle, bottom };
+
+inline constexpr u32 replacement_char = 0xFFFD;
+
+// decode the utf-8 sequence at p and step past it. malformed or truncated
+// sequences give U+FFFD and consume a single byte.
+constexpr u32 utf8_next(const char*& p) {
+  u8 b = static_cast<u8>(*p++);
+  if (b < 0x80) return b;
+  u8 extra = b >= 0xF0 ? 3 : b >= 0xE0 ? 2 : b >= 0xC0 ? 1 : 0;
+  if (!extra || b >= 0xF8) return replacement_char;
+  u32 cp = b & (0x3F >> extra);
+  for (u8 i = 0; i < extra; ++i) {
+    u8 c = static_cast<u8>(p[i]);
+    if ((c & 0xC0) != 0x80) return replacement_char;
+    cp = (cp << 6) | (c & 0x3F);
+  }
+  p += extra;
+  return cp;
+}
+
+// font and scale, everything measurement needs. a null font is the
+// builtin 5x7 (6 px advance, ascii only), positioned by its top edge;
+// proportional fonts are positioned by their baseline.
+struct text_style {
+  const font* face = nullptr;
+  u8 sx = 1;
+  u8 sy = 1;
+
+  constexpr u16 advance(u32 cp) const {
+    if (!face) return cp >= 32 && cp <= 126 ? static_cast<u16>(6 * sx) : 0;
+    const glyph* g = find_glyph(*face, cp);
+    return g ? static_cast<u16>(g->x_advance * sx) : 0;
+  }
+
+  constexpr u16 line_height() const {
+    return static_cast<u16>((face ? face->y_advance : 8) * sy);
+  }
+
+  // line top to the y a glyph is drawn at; 'A' stands in for the ascent
+  constexpr i16 ascent() const {
+    if (!face) return 0;
+    const glyph* g = find_glyph(*face, 'A');
+    i16 a = g ? static_cast<i16>(-g->y_offset) : face->y_advance * 3 / 4;
+    return static_cast<i16>(a * sy);
+  }
+};
+
+// width of the text in [s, end), stopping early at a newline
+constexpr u16 measure_line(const text_style& st, const char* s,
+                           const char* end) {
+  u16 w = 0;
+  while (s < end && *s != '\n')
+    w = static_cast<u16>(w + st.advance(utf8_next(s)));
+  return w;
+}
+
+// unwrapped extent: the widest line by the line count times line height
+constexpr size measure(const text_style& st, const char* s) {
+  size out{0, st.line_height()};
+  while (true) {
+    u16 w = 0;
+    while (*s && *s != '\n')
+      w = static_cast<u16>(w + st.advance(utf8_next(s)));
+    if (w > out.w) out.w = w;
+    if (!*s) return out;
+    ++s;
+    out.h = static_cast<u16>(out.h + st.line_height());
+  }
+}
+
+// one wrapped line: [begin, end) is drawn, next starts the following line
+struct wrapped_line {
+  const char* begin;
+  const char* end;
+  const char* next;
+  u16 width;
+};
+
+// take as much of s as fits in max_width, breaking after the last space
+// that fits. a word wider than the whole line is split between
+// characters, and newlines always break. spaces at the break are dropped.
+constexpr wrapped_line wrap_line(const text_style& st, const char* s,
+                                 u16 max_width) {
+  const char* p = s;
+  const char* brk = nullptr;  // end of the text before the last space
+  u16 brk_w = 0, w = 0;
+  while (*p && *p != '\n') {
+    const char* at = p;
+    u32 cp = utf8_next(p);
+    u16 a = st.advance(cp);
+    if (cp == ' ') {
+      if (at > s && at[-1] != ' ') {
+        brk = at;
+        brk_w = w;
+      }
+    } else if (w + a > max_width && at > s) {
+      if (brk) {
+        const char* next = brk;
+        while (*next == ' ') ++next;
+        return {s, brk, next, brk_w};
+      }
+      return {s, at, at, w};
+    }
+    w = static_cast<u16>(w + a);
+  }
+  const char* end = p;
+  u16 end_w = w;
+  // trailing spaces don't count toward the line width
+  while (end > s && end[-1] == ' ') {
+    --end;
+    end_w = static_cast<u16>(end_w - st.advance(' '));
+  }
+  return {s, end, *p == '\n' ? p + 1 : p, end_w};
+}
+
+// wrap s into lines no wider than max_width and call f(wrapped_line) for
+// each, top to bottom, until f returns false. a trailing newline ends in
+// an empty line; empty text is one empty line. returns the lines visited.
+template <typename F>
+constexpr u16 for_each_line(const text_style& st, const char* s, u16 max_width,
+                            F&& f) {
+  u16 n = 0;
+  const char* p = s;
+  do {
+    wrapped_line l = wrap_line(st, p, max_width);
+    ++n;
+    if (!f(l) || l.next == p) break;
+    p = l.next;
+  } while (*p || p[-1] == '\n');
+  return n;
+}
+
+struct text_line {
+  u16 offset;  // bytes into the text
+  u16 length;  // bytes
+  u16 width;   // pixels
+};
+
+// word-wrapped layout of a string, kept so text that doesn't change isn't
+// measured again every frame. the string is referenced, not copied. lines
+// beyond MaxLines are dropped and flagged by truncated().
+template <usize MaxLines>
+class text_layout {
+ public:
+  constexpr text_layout() = default;
+
+  constexpr text_layout(const char* s, const text_style& st, u16 max_width) {
+    layout(s, st, max_width);
+  }
+
+  constexpr void layout(const char* s, const text_style& st, u16 max_width) {
+    text_ = s;
+    style_ = st;
+    count_ = 0;
+    truncated_ = false;
+    extent_ = {};
+    for_each_line(st, s, max_width, [&](const wrapped_line& l) {
+      if (count_ == MaxLines) {
+        truncated_ = true;
+        return false;
+      }
+      lines_[count_++] = {static_cast<u16>(l.begin - s),
+                          static_cast<u16>(l.end - l.begin), l.width};
+      if (l.width > extent_.w) extent_.w = l.width;
+      return true;
+    });
+    extent_.h = static_cast<u16>(count_ * st.line_height());
+  }
+
+  const char* text() const { return text_; }
+  const text_style& style() const { return style_; }
+  std::span<const text_line> lines() const { return {lines_, count_}; }
+  size extent() const { return extent_; }
+  bool truncated() const { return truncated_; }
+
+ private:
+  const char* text_ = "";
+  text_style style_;
+  text_line lines_[MaxLines] = {};
+  u16 count_ = 0;
+  size extent_;
+  bool truncated_ = false;
+};
+
+}  // namespace jpico::graphics
@@ -53,6 +53,41 @@ class dma_channel {
 
   bool busy() const { return dma_channel_is_busy(static_cast<u32>(channel_)); }
 
+  // crc-32 of `rows` rows of `row_bytes` bytes, `stride` bytes apart,
+  // computed by the dma sniffer while streaming them into a dummy word.
+  // `self` is the dma_channel to use; the signature matches
+  // graphics::tile_hash_fn.
+  static u32 sniff_crc32(void* self, const u8* data, usize stride,
+                         usize row_bytes, u16 rows) {
+    auto& dma = *static_cast<dma_channel*>(self);
+    u32 ch = static_cast<u32>(dma.channel_);
+    static u32 sink;
+
+    dma_channel_config words = dma.default_config();
+    channel_config_set_transfer_data_size(&words, DMA_SIZE_32);
+    channel_config_set_read_increment(&words, true);
+    channel_config_set_write_increment(&words, false);
+    channel_config_set_sniff_enable(&words, true);
+    dma_channel_config bytes = words;
+    channel_config_set_transfer_data_size(&bytes, DMA_SIZE_8);
+
+    dma_sniffer_enable(ch, DMA_SNIFF_CTRL_CALC_VALUE_CRC32, true);
+    dma_sniffer_set_data_accumulator(0xFFFFFFFF);
+    for (u16 r = 0; r < rows; ++r, data += stride) {
+      bool aligned =
+          ((reinterpret_cast<std::uintptr_t>(data) | row_bytes) & 3) == 0;
+      if (aligned) {
+        dma.transfer(data, &sink, static_cast<u32>(row_bytes / 4), words);
+      } else {
+        dma.transfer(data, &sink, static_cast<u32>(row_bytes), bytes);
+      }
+      dma.wait();
+    }
+    u32 crc = dma_sniffer_get_data_accumulator();
+    dma_sniffer_disable();
+    return crc;
+  }
+
  private:
   int channel_;
 };
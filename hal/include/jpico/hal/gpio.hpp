@@ -2,6 +2,7 @@
 
 #include <jpico/types.hpp>
 
+#include "hardware/irq.h"
 #include "pico/stdlib.h"
 
 namespace jpico::hal {
@@ -59,6 +60,63 @@ class input_pin {
   u8 pin_;
 };
 
+// calls fn(ctx) in interrupt context on each rising edge of an input pin,
+// e.g. a display's TE output. each pin gets its own raw handler on the
+// shared bank interrupt, so the sdk's gpio callback and other raw handlers
+// keep their events. one edge_irq per pin; attached() is false when all
+// max_pins were taken.
+class edge_irq {
+ public:
+  using handler = void (*)(void* ctx);
+  static constexpr u8 max_pins = 4;
+
+  edge_irq(const input_pin& pin, handler fn, void* ctx) : pin_{pin.pin()} {
+    for (u8 i = 0; i < max_pins; ++i) {
+      if (slots_[i].fn) continue;
+      slots_[i] = {pin_, fn, ctx};
+      index_ = i;
+      gpio_add_raw_irq_handler(pin_, raw_handlers_[i]);
+      gpio_set_irq_enabled(pin_, GPIO_IRQ_EDGE_RISE, true);
+      irq_set_enabled(IO_IRQ_BANK0, true);
+      return;
+    }
+  }
+
+  ~edge_irq() {
+    if (!attached()) return;
+    gpio_set_irq_enabled(pin_, GPIO_IRQ_EDGE_RISE, false);
+    gpio_remove_raw_irq_handler(pin_, raw_handlers_[index_]);
+    slots_[index_] = {};
+  }
+
+  bool attached() const { return index_ < max_pins; }
+
+  edge_irq(const edge_irq&) = delete;
+  edge_irq& operator=(const edge_irq&) = delete;
+
+ private:
+  struct slot {
+    u8 pin;
+    handler fn;  // null when free
+    void* ctx;
+  };
+
+  // raw handlers get no arguments, so each slot has its own
+  template <u8 I>
+  static void on_irq() {
+    const slot& s = slots_[I];
+    if (!(gpio_get_irq_event_mask(s.pin) & GPIO_IRQ_EDGE_RISE)) return;
+    gpio_acknowledge_irq(s.pin, GPIO_IRQ_EDGE_RISE);
+    s.fn(s.ctx);
+  }
+
+  inline static slot slots_[max_pins] = {};
+  static constexpr irq_handler_t raw_handlers_[max_pins] = {
+      &on_irq<0>, &on_irq<1>, &on_irq<2>, &on_irq<3>};
+  u8 pin_;
+  u8 index_ = max_pins;  // slot in use
+};
+
 class cs_guard {
  public:
   explicit cs_guard(output_pin& cs) : cs_{cs} { cs_.low(); }
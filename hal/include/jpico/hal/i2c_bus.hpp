@@ -1,6 +1,7 @@
 #pragma once
 
 #include <jpico/result.hpp>
+#include <jpico/stats.hpp>
 #include <jpico/types.hpp>
 #include <span>
 
@@ -29,7 +30,7 @@ class i2c_bus {
   ~i2c_bus() { i2c_deinit(inst_); }
 
   i2c_bus(i2c_bus&& other) noexcept
-      : inst_{other.inst_}, config_{other.config_} {
+      : inst_{other.inst_}, config_{other.config_}, stats_{other.stats_} {
     other.inst_ = nullptr;
   }
 
@@ -38,6 +39,7 @@ class i2c_bus {
       if (inst_) i2c_deinit(inst_);
       inst_ = other.inst_;
       config_ = other.config_;
+      stats_ = other.stats_;
       other.inst_ = nullptr;
     }
     return *this;
@@ -51,6 +53,7 @@ class i2c_bus {
     if (n < 0) {
       return fail(error_code::io_error, "i2c write failed");
     }
+    stats_.record(static_cast<usize>(n));
     return ok(static_cast<usize>(n));
   }
 
@@ -59,6 +62,7 @@ class i2c_bus {
     if (n < 0) {
       return fail(error_code::io_error, "i2c read failed");
     }
+    stats_.record(static_cast<usize>(n));
     return ok(static_cast<usize>(n));
   }
 
@@ -71,9 +75,15 @@ class i2c_bus {
   i2c_inst_t* instance() const { return inst_; }
   const i2c_config& config() const { return config_; }
 
+  // payload bytes written and read since the last reset (JPICO_STATS
+  // builds); addressing and acks are not counted
+  const bus_stats& stats() const { return stats_; }
+  void reset_stats() { stats_ = {}; }
+
  private:
   i2c_inst_t* inst_;
   i2c_config config_;
+  bus_stats stats_;
 };
 
 }  // namespace jpico::hal
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <jpico/result.hpp>
+#include <jpico/stats.hpp>
 #include <jpico/types.hpp>
 #include <span>
 
@@ -23,6 +24,7 @@ class spi_bus {
   spi_bus(spi_inst_t* inst, spi_config cfg) : inst_{inst}, config_{cfg} {
     spi_init(inst_, config_.baudrate);
     spi_set_format(inst_, 8, config_.cpol, config_.cpha, SPI_MSB_FIRST);
+    format_ = {8, config_.cpol, config_.cpha};
 
     gpio_set_function(config_.pin_sck, GPIO_FUNC_SPI);
     gpio_set_function(config_.pin_tx, GPIO_FUNC_SPI);
@@ -34,7 +36,10 @@ class spi_bus {
   ~spi_bus() { spi_deinit(inst_); }
 
   spi_bus(spi_bus&& other) noexcept
-      : inst_{other.inst_}, config_{other.config_} {
+      : inst_{other.inst_},
+        config_{other.config_},
+        format_{other.format_},
+        stats_{other.stats_} {
     other.inst_ = nullptr;
   }
 
@@ -43,6 +48,8 @@ class spi_bus {
       if (inst_) spi_deinit(inst_);
       inst_ = other.inst_;
       config_ = other.config_;
+      format_ = other.format_;
+      stats_ = other.stats_;
       other.inst_ = nullptr;
     }
     return *this;
@@ -55,6 +62,7 @@ class spi_bus {
     set_format(8, config_.cpol, config_.cpha);
     auto n =
         spi_write_blocking(inst_, data.data(), static_cast<usize>(data.size()));
+    stats_.record(static_cast<usize>(n));
     return ok(static_cast<usize>(n));
   }
 
@@ -62,6 +70,7 @@ class spi_bus {
     set_format(16, config_.cpol, config_.cpha);
     auto n = spi_write16_blocking(inst_, data.data(),
                                   static_cast<usize>(data.size()));
+    stats_.record(static_cast<usize>(n) * 2);
     return ok(static_cast<usize>(n));
   }
 
@@ -70,6 +79,7 @@ class spi_bus {
     auto len = std::min(tx.size(), rx.size());
     auto n = spi_write_read_blocking(inst_, tx.data(), rx.data(),
                                      static_cast<usize>(len));
+    stats_.record(static_cast<usize>(n));
     return ok(static_cast<usize>(n));
   }
 
@@ -79,11 +89,17 @@ class spi_bus {
     auto len = std::min(tx.size(), rx.size());
     auto n = spi_write_read_blocking(inst_, tx.data(), rx.data(),
                                      static_cast<usize>(len));
+    stats_.record(static_cast<usize>(n));
     return ok(static_cast<usize>(n));
   }
 
+  // a no-op when the format is already set: drivers sharing the bus call
+  // this before every transaction
   void set_format(u8 bits, spi_cpol_t cpol, spi_cpha_t cpha) {
+    if (format_.bits == bits && format_.cpol == cpol && format_.cpha == cpha)
+      return;
     spi_set_format(inst_, bits, cpol, cpha, SPI_MSB_FIRST);
+    format_ = {bits, cpol, cpha};
   }
 
   u32 set_baudrate(u32 baud) { return spi_set_baudrate(inst_, baud); }
@@ -91,9 +107,23 @@ class spi_bus {
   spi_inst_t* instance() const { return inst_; }
   const spi_config& config() const { return config_; }
 
+  // bytes clocked out since the last reset (JPICO_STATS builds). drivers
+  // that call the sdk on instance() directly record their own traffic here.
+  bus_stats& stats() { return stats_; }
+  const bus_stats& stats() const { return stats_; }
+  void reset_stats() { stats_ = {}; }
+
  private:
+  struct format {
+    u8 bits;
+    spi_cpol_t cpol;
+    spi_cpha_t cpha;
+  };
+
   spi_inst_t* inst_;
   spi_config config_;
+  format format_;
+  bus_stats stats_;
 };
 
 }  // namespace jpico::hal
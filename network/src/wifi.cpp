@@ -50,7 +50,7 @@ result<void> wifi_manager::connect(const wifi_config& config) {
   }
 
   update_status(wifi_status::connected);
-  log::info("wifi connected: %s", ip_string());
+  log::info("wifi connected: {}", ip_string());
   return ok();
 }
 
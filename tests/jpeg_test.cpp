@@ -0,0 +1,117 @@
+// malformed input must make jpeg_decoder fail cleanly
+#include <cstdio>
+#include <cstring>
+#include <jpico/graphics/jpeg.hpp>
+#include <jpico/platform.hpp>
+
+static_assert(!JPICO_ON_DEVICE, "jpeg_test is a host program");
+
+using namespace jpico;
+using namespace jpico::graphics;
+
+namespace {
+
+jpeg_decoder jpeg;
+int failures = 0;
+
+// 32x32 grayscale, 16 mcus
+const u8 gray[] = {
+    0xFF, 0xD8, 0xFF, 0xE0, 0x00, 0x10, 0x4A, 0x46, 0x49, 0x46, 0x00, 0x01,
+    0x01, 0x00, 0x00, 0x01, 0x00, 0x01, 0x00, 0x00, 0xFF, 0xDB, 0x00, 0x43,
+    0x00, 0x08, 0x06, 0x06, 0x07, 0x06, 0x05, 0x08, 0x07, 0x07, 0x07, 0x09,
+    0x09, 0x08, 0x0A, 0x0C, 0x14, 0x0D, 0x0C, 0x0B, 0x0B, 0x0C, 0x19, 0x12,
+    0x13, 0x0F, 0x14, 0x1D, 0x1A, 0x1F, 0x1E, 0x1D, 0x1A, 0x1C, 0x1C, 0x20,
+    0x24, 0x2E, 0x27, 0x20, 0x22, 0x2C, 0x23, 0x1C, 0x1C, 0x28, 0x37, 0x29,
+    0x2C, 0x30, 0x31, 0x34, 0x34, 0x34, 0x1F, 0x27, 0x39, 0x3D, 0x38, 0x32,
+    0x3C, 0x2E, 0x33, 0x34, 0x32, 0xFF, 0xC0, 0x00, 0x0B, 0x08, 0x00, 0x20,
+    0x00, 0x20, 0x01, 0x01, 0x11, 0x00, 0xFF, 0xC4, 0x00, 0x18, 0x00, 0x01,
+    0x00, 0x03, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x06, 0x05, 0x07, 0x08, 0x04, 0xFF, 0xC4, 0x00, 0x26,
+    0x10, 0x00, 0x01, 0x03, 0x04, 0x02, 0x01, 0x03, 0x05, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x02, 0x03, 0x04, 0x00, 0x05, 0x11,
+    0x21, 0x06, 0x32, 0x12, 0x13, 0x23, 0x31, 0x07, 0x15, 0x22, 0x41, 0xB1,
+    0xFF, 0xDA, 0x00, 0x08, 0x01, 0x01, 0x00, 0x00, 0x3F, 0x00, 0xAA, 0x6D,
+    0x50, 0x3A, 0xEA, 0x9C, 0x5A, 0xA0, 0x75, 0xD5, 0x38, 0xB5, 0x40, 0xEB,
+    0xAA, 0x71, 0x6A, 0x81, 0xD7, 0x55, 0x9F, 0xED, 0x50, 0x3A, 0xEA, 0x9C,
+    0x5A, 0xA0, 0x75, 0xD5, 0x38, 0xB5, 0x40, 0xEB, 0xAA, 0x1F, 0xF5, 0x7F,
+    0x9C, 0xFD, 0x96, 0xDC, 0x78, 0xAD, 0xA5, 0xC6, 0x17, 0x3A, 0x73, 0x4A,
+    0x44, 0xF5, 0x76, 0x54, 0x76, 0x54, 0x00, 0xF1, 0xC6, 0x30, 0x14, 0xB0,
+    0x4F, 0xC9, 0xC8, 0x4E, 0xF1, 0xF9, 0x25, 0x42, 0x1E, 0xD5, 0x03, 0xAE,
+    0xA9, 0xC5, 0xAA, 0x07, 0x5D, 0x54, 0x87, 0x2B, 0xE4, 0x51, 0xF8, 0x37,
+    0x12, 0x7E, 0xEC, 0xEA, 0x7C, 0xA4, 0x2B, 0xD9, 0x86, 0xD9, 0x6C, 0xA8,
+    0x38, 0xF9, 0x49, 0x28, 0x0A, 0xC1, 0x18, 0x4E, 0x89, 0x3B, 0x1A, 0x07,
+    0x1B, 0xC0, 0x39, 0xAF, 0xD6, 0x9D, 0x7C, 0xBA, 0x3F, 0x73, 0xB9, 0xC8,
+    0x72, 0x4C, 0xC9, 0x0B, 0xF3, 0x75, 0xD5, 0xFC, 0xA8, 0xFF, 0x00, 0x00,
+    0x03, 0x00, 0x01, 0xA0, 0x00, 0x03, 0x00, 0x55, 0xE9, 0x6A, 0x81, 0xD7,
+    0x54, 0xD2, 0x0C, 0x76, 0x62, 0xC7, 0x5C, 0x89, 0x0E, 0x36, 0xCB, 0x0D,
+    0x20, 0xAD, 0xC7, 0x1C, 0x50, 0x4A, 0x50, 0x90, 0x32, 0x49, 0x27, 0x40,
+    0x01, 0xBC, 0xD6, 0x6B, 0xE6, 0x7C, 0xAE, 0x47, 0x3C, 0xE5, 0x0B, 0x9D,
+    0xEF, 0xB7, 0x6D, 0x6B, 0xDB, 0x83, 0x15, 0xD5, 0x03, 0xE9, 0x23, 0x03,
+    0x27, 0x03, 0x5E, 0x4A, 0x23, 0xC8, 0xFC, 0xFE, 0x86, 0x48, 0x48, 0xAE,
+    0x8B, 0x54, 0x0E, 0xBA, 0xAF, 0xFF, 0xD9,
+};
+
+void expect(bool ok, const char* what) {
+  if (ok) return;
+  std::printf("FAIL: %s\n", what);
+  ++failures;
+}
+
+// two codes of length 1 use up the tree; four more of length 2 would
+// index past the 256-entry lookup
+void over_subscribed_huffman() {
+  const u8 data[] = {
+      0xFF, 0xD8,              // soi
+      0xFF, 0xC4, 0x00, 0x19,  // dht, 23 bytes after the length
+      0x00,                    // dc table 0
+      2, 4, 0, 0, 0, 0, 0, 0,  // codes of length 1-8
+      0, 0, 0, 0, 0, 0, 0, 0,  // codes of length 9-16
+      0, 1, 2, 3, 4, 5,        // symbols
+      0xFF, 0xD9,              // eoi
+  };
+  auto r = jpeg.open(data);
+  expect(!r && r.error().code == error_code::io_error,
+         "over-subscribed huffman table accepted");
+}
+
+result<void> decode(std::span<const u8> data) {
+  auto r = jpeg.open(data);
+  if (!r) return r;
+  return jpeg.decode([](i16, i16, u16, u16, const u16*) {});
+}
+
+// input that stops inside the scan is an error, not zero-filled blocks
+void truncated_scan() {
+  expect(bool(decode(gray)), "whole file failed");
+  for (usize cut = 200; cut < sizeof(gray) - 40; cut += 7) {
+    auto r = decode(std::span{gray, cut});
+    expect(!r && r.error().code == error_code::io_error,
+           "truncated scan decoded");
+  }
+}
+
+// corrupt headers and data may decode to anything, but must not take the
+// idct out of range (the sanitizer aborts on overflow)
+void corrupt_file() {
+  u8 bad[sizeof(gray)];
+  u32 x = 1;
+  for (int n = 0; n < 256; ++n) {
+    std::memcpy(bad, gray, sizeof(gray));
+    for (int k = 0; k < 4; ++k) {
+      x = x * 1103515245 + 12345;
+      bad[2 + (x >> 8) % (sizeof(gray) - 4)] = static_cast<u8>(x >> 24);
+    }
+    (void)decode(bad);
+  }
+}
+
+}  // namespace
+
+int main() {
+  over_subscribed_huffman();
+  truncated_scan();
+  corrupt_file();
+  if (failures) return 1;
+  std::printf("jpeg ok\n");
+  return 0;
+}
@@ -0,0 +1,518 @@
+#!/usr/bin/env python3
+"""jpico_assets: convert fonts and images into constexpr headers for jpico.
+
+fonts (bdf, or ttf/otf when pillow is installed) become a graphics::font with
+a sparse glyph index. images (png) become a graphics::image, palette_image or
+rle_image, whichever is smallest; rle images store transparency as skip
+runs. everything is emitted as constexpr data so
+it stays in xip flash and needs no decoding at startup.
+
+usage:
+  jpico_assets.py font  --name NAME --source FILE --size PX [--ranges R]
+                        --output FILE.hpp [--namespace NS]
+  jpico_assets.py image --name NAME --source FILE [--encoding E] [--key C]
+                        --output FILE.hpp [--namespace NS]
+"""
+
+import argparse
+import os
+import struct
+import zlib
+
+# --------------------------------------------------------------------------
+# shared helpers
+
+
+def rgb565(r, g, b):
+    return ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3)
+
+
+def c_array(ctype, name, values, per_line=12, fmt="0x{:02X}"):
+    out = [f"inline constexpr {ctype} {name}[] = {{"]
+    for i in range(0, len(values), per_line):
+        chunk = values[i:i + per_line]
+        out.append("    " + ", ".join(fmt.format(v) for v in chunk) + ",")
+    out.append("};")
+    return "\n".join(out)
+
+
+def write_header(path, source, summary, includes, namespace, body):
+    os.makedirs(os.path.dirname(os.path.abspath(path)), exist_ok=True)
+    text = [
+        f"// generated by jpico_assets from {os.path.basename(source)}, do not edit.",
+        f"// {summary}",
+        "#pragma once",
+    ]
+    text += [f"#include <{inc}>" for inc in includes]
+    text += ["", f"namespace {namespace} {{", "", body, "", f"}}  // namespace {namespace}", ""]
+    new = "\n".join(text)
+    # only touch the file when it changes so dependents don't rebuild
+    if os.path.exists(path):
+        with open(path) as f:
+            if f.read() == new:
+                return
+    with open(path, "w") as f:
+        f.write(new)
+
+
+def report(name, kind, detail, nbytes, raw=None):
+    extra = f" (raw {raw}, {raw / max(nbytes, 1):.1f}x)" if raw else ""
+    print(f"jpico_assets: {name:<20} {kind:<8} {detail:<12} {nbytes:>8} bytes{extra}")
+
+
+# --------------------------------------------------------------------------
+# png loading. pillow is used when available, otherwise a small decoder that
+# handles non-interlaced 8-bit (and sub-byte palette/gray) pngs.
+
+
+def load_png_builtin(path):
+    with open(path, "rb") as f:
+        blob = f.read()
+    if blob[:8] != b"\x89PNG\r\n\x1a\n":
+        raise SystemExit(f"{path}: not a png")
+
+    pos, idat, plte, trns = 8, b"", None, None
+    while pos < len(blob):
+        length, kind = struct.unpack(">I4s", blob[pos:pos + 8])
+        chunk = blob[pos + 8:pos + 8 + length]
+        pos += 12 + length
+        if kind == b"IHDR":
+            w, h, depth, ctype, _, _, interlace = struct.unpack(">IIBBBBB", chunk)
+        elif kind == b"PLTE":
+            plte = [tuple(chunk[i:i + 3]) for i in range(0, len(chunk), 3)]
+        elif kind == b"tRNS":
+            trns = chunk
+        elif kind == b"IDAT":
+            idat += chunk
+        elif kind == b"IEND":
+            break
+
+    if interlace:
+        raise SystemExit(f"{path}: interlaced png needs pillow")
+    channels = {0: 1, 2: 3, 3: 1, 4: 2, 6: 4}[ctype]
+    bits = depth * channels
+    stride = (w * bits + 7) // 8
+    bpp = max(1, bits // 8)
+    raw = zlib.decompress(idat)
+
+    rows, prev = [], bytearray(stride)
+    for y in range(h):
+        ftype = raw[y * (stride + 1)]
+        line = bytearray(raw[y * (stride + 1) + 1:(y + 1) * (stride + 1)])
+        for i in range(stride):
+            a = line[i - bpp] if i >= bpp else 0
+            b = prev[i]
+            c = prev[i - bpp] if i >= bpp else 0
+            if ftype == 1:
+                line[i] = (line[i] + a) & 0xFF
+            elif ftype == 2:
+                line[i] = (line[i] + b) & 0xFF
+            elif ftype == 3:
+                line[i] = (line[i] + ((a + b) >> 1)) & 0xFF
+            elif ftype == 4:
+                p = a + b - c
+                pa, pb, pc = abs(p - a), abs(p - b), abs(p - c)
+                pr = a if pa <= pb and pa <= pc else (b if pb <= pc else c)
+                line[i] = (line[i] + pr) & 0xFF
+        rows.append(line)
+        prev = line
+
+    def samples(line):
+        if depth == 8:
+            return list(line)
+        if depth == 16:
+            return list(line[0::2])
+        per = 8 // depth
+        mask = (1 << depth) - 1
+        out = []
+        for byte in line:
+            for k in range(per):
+                out.append((byte >> (8 - depth * (k + 1))) & mask)
+        return out
+
+    pixels = []
+    for line in rows:
+        s = samples(line)
+        for x in range(w):
+            if ctype == 0:
+                v = s[x] * 255 // ((1 << min(depth, 8)) - 1)
+                pixels.append((v, v, v, 255))
+            elif ctype == 2:
+                pixels.append((s[3 * x], s[3 * x + 1], s[3 * x + 2], 255))
+            elif ctype == 3:
+                i = s[x]
+                a = trns[i] if trns and i < len(trns) else 255
+                pixels.append(plte[i] + (a,))
+            elif ctype == 4:
+                pixels.append((s[2 * x], s[2 * x], s[2 * x], s[2 * x + 1]))
+            else:
+                pixels.append(tuple(s[4 * x:4 * x + 4]))
+    return w, h, pixels
+
+
+def load_png(path):
+    try:
+        from PIL import Image
+    except ImportError:
+        return load_png_builtin(path)
+    im = Image.open(path).convert("RGBA")
+    return im.width, im.height, list(im.getdata())
+
+
+# --------------------------------------------------------------------------
+# image encoders
+
+
+def rle_hash(c):
+    return (c ^ (c >> 6) ^ (c >> 11)) & 63
+
+
+def encode_rle(w, h, px, transparent):
+    # mirrors graphics::detail::rle_reader, see rle_image in image.hpp
+    out = bytearray()
+    cache = [0] * 64
+    prev = 0
+
+    for y in range(h):
+        row = px[y * w:(y + 1) * w]
+        clear = transparent[y * w:(y + 1) * w]
+        x = 0
+        while x < w:
+            n = 0
+            if clear[x]:
+                while x + n < w and n < 64 and clear[x + n]:
+                    n += 1
+                out.append(n - 1)
+            elif row[x] == prev:
+                while x + n < w and n < 64 and not clear[x + n] and row[x + n] == prev:
+                    n += 1
+                out.append(0x40 | (n - 1))
+            elif cache[rle_hash(row[x])] == row[x]:
+                prev = row[x]
+                n = 1
+                out.append(0x80 | rle_hash(prev))
+            else:
+                lit = []
+                while x + n < w and n < 64 and not clear[x + n]:
+                    c = row[x + n]
+                    if lit and (c == prev or cache[rle_hash(c)] == c):
+                        break
+                    lit.append(c)
+                    cache[rle_hash(c)] = c
+                    prev = c
+                    n += 1
+                out.append(0xC0 | (n - 1))
+                for c in lit:
+                    out.extend(struct.pack("<H", c))
+            x += n
+    return bytes(out)
+
+
+def encode_palette(w, h, px, palette):
+    n = len(palette)
+    bpp = next(b for b in (1, 2, 4, 8) if n <= (1 << b))
+    lookup = {c: i for i, c in enumerate(palette)}
+    out = bytearray()
+    for y in range(h):
+        acc, nbits = 0, 0
+        for x in range(w):
+            acc = (acc << bpp) | lookup[px[y * w + x]]
+            nbits += bpp
+            if nbits == 8:
+                out.append(acc)
+                acc, nbits = 0, 0
+        if nbits:
+            out.append(acc << (8 - nbits))
+    return bpp, bytes(out)
+
+
+def pick_key(used, requested):
+    if requested is not None:
+        return requested
+    for c in [0xF81F] + list(range(0x10000)):
+        if c not in used:
+            return c
+    raise SystemExit("image uses every rgb565 color, no free color key")
+
+
+def encode_alpha(w, h, rgba, bits):
+    if bits == 8:
+        return bytes(a for (_, _, _, a) in rgba)
+    out = bytearray()
+    for y in range(h):
+        row = [(a * 15 + 127) // 255 for (_, _, _, a) in rgba[y * w:(y + 1) * w]]
+        if w & 1:
+            row.append(0)
+        out += bytes((row[i] << 4) | row[i + 1] for i in range(0, w, 2))
+    return bytes(out)
+
+
+def cmd_alpha_image(args):
+    # a side channel only makes sense next to raw pixels
+    w, h, rgba = load_png(args.source)
+    bits = 8 if args.alpha == "a8" else 4
+    px = [rgb565(r, g, b) for (r, g, b, _) in rgba]
+    adata = encode_alpha(w, h, rgba, bits)
+
+    ns, name = args.namespace, args.name
+    body = c_array("jpico::u16", f"{name}_data", px, 8, "0x{:04X}")
+    body += "\n\n" + c_array("jpico::u8", f"{name}_alpha", list(adata))
+    body += (f"\n\ninline constexpr jpico::graphics::image {name}{{"
+             f"{w}, {h}, {name}_data, 0, false, {name}_alpha, {bits}}};")
+
+    raw_size = w * h * 2
+    nbytes = raw_size + len(adata)
+    detail = f"{w}x{h} {args.alpha}"
+    summary = f"raw {detail}: {nbytes} bytes"
+    write_header(args.output, args.source, summary,
+                 ["jpico/graphics/image.hpp"], ns, body)
+    report(name, "raw", detail, nbytes)
+
+
+def cmd_image(args):
+    if args.alpha != "none":
+        return cmd_alpha_image(args)
+    w, h, rgba = load_png(args.source)
+    transparent = [a < 128 for (_, _, _, a) in rgba]
+    px = [rgb565(r, g, b) for (r, g, b, _) in rgba]
+    keyed = any(transparent) or args.key is not None
+
+    key = None
+    if keyed:
+        key = pick_key(set(c for c, t in zip(px, transparent) if not t), args.key)
+        px = [key if t else c for c, t in zip(px, transparent)]
+        transparent = [c == key for c in px]
+        if not any(transparent):
+            raise SystemExit(f"{args.source}: key 0x{key:04X} is not used, the "
+                             "image has no transparent or key-colored pixels")
+
+    raw_size = w * h * 2
+    palette = sorted(set(px))
+    candidates = {"raw": raw_size}
+    if len(palette) <= 256:
+        bpp, pdata = encode_palette(w, h, px, palette)
+        candidates["palette"] = len(pdata) + 2 * len(palette)
+    rdata = encode_rle(w, h, px, transparent)
+    candidates["rle"] = len(rdata)
+
+    enc = args.encoding
+    if enc == "auto":
+        # smallest wins; ties go to the cheaper decode (dict order)
+        enc = min(candidates, key=lambda k: candidates[k])
+    elif enc not in candidates:
+        raise SystemExit(f"{args.source}: {enc} encoding not possible for this image")
+
+    ns, name = args.namespace, args.name
+    key_init = ""
+    if enc == "raw":
+        body = c_array("jpico::u16", f"{name}_data", px, 8, "0x{:04X}")
+        if keyed:
+            key_init = f", 0x{key:04X}, true"
+        body += (f"\n\ninline constexpr jpico::graphics::image {name}{{"
+                 f"{w}, {h}, {name}_data{key_init}}};")
+    elif enc == "palette":
+        body = c_array("jpico::u16", f"{name}_palette", palette, 8, "0x{:04X}")
+        body += "\n\n" + c_array("jpico::u8", f"{name}_data", list(pdata))
+        if keyed:
+            key_init = f", {palette.index(key)}, true"
+        body += (f"\n\ninline constexpr jpico::graphics::palette_image {name}{{"
+                 f"{w}, {h}, {bpp}, {name}_data, {name}_palette{key_init}}};")
+    else:
+        body = c_array("jpico::u8", f"{name}_data", list(rdata))
+        body += (f"\n\ninline constexpr jpico::graphics::rle_image {name}{{"
+                 f"{w}, {h}, {name}_data, sizeof({name}_data)}};")
+
+    nbytes = candidates[enc]
+    detail = f"{w}x{h}"
+    summary = f"{enc} {detail}: {nbytes} bytes (raw {raw_size})"
+    write_header(args.output, args.source, summary,
+                 ["jpico/graphics/image.hpp"], ns, body)
+    report(name, enc, detail, nbytes, raw_size if enc != "raw" else None)
+
+
+# --------------------------------------------------------------------------
+# font loading. each loader returns (y_advance, {codepoint: glyph}) where a
+# glyph is (width, height, x_advance, x_offset, y_offset, rows) and rows is a
+# list of lists of 0/1. offsets follow the canvas convention: y_offset is
+# from the baseline to the top of the bitmap.
+
+
+def load_bdf(path, wanted):
+    glyphs = {}
+    ascent = descent = 0
+    pixel_size = None
+    with open(path, encoding="latin-1") as f:
+        lines = iter(f.read().splitlines())
+
+    for line in lines:
+        parts = line.split()
+        if not parts:
+            continue
+        if parts[0] == "FONT_ASCENT":
+            ascent = int(parts[1])
+        elif parts[0] == "FONT_DESCENT":
+            descent = int(parts[1])
+        elif parts[0] == "PIXEL_SIZE":
+            pixel_size = int(parts[1])
+        elif parts[0] == "STARTCHAR":
+            cp, adv, bbx, rows = -1, 0, (0, 0, 0, 0), []
+            for line in lines:
+                parts = line.split()
+                if parts[0] == "ENCODING":
+                    cp = int(parts[1])
+                elif parts[0] == "DWIDTH":
+                    adv = int(parts[1])
+                elif parts[0] == "BBX":
+                    bbx = tuple(int(v) for v in parts[1:5])
+                elif parts[0] == "BITMAP":
+                    for line in lines:
+                        if line.startswith("ENDCHAR"):
+                            break
+                        bits = int(line, 16)
+                        nb = len(line.strip()) * 4
+                        rows.append([(bits >> (nb - 1 - i)) & 1 for i in range(bbx[0])])
+                    break
+            if cp in wanted:
+                bw, bh, bx, by = bbx
+                glyphs[cp] = (bw, bh, adv, bx, -(by + bh), rows)
+
+    return (ascent + descent) or pixel_size or 0, glyphs
+
+
+def load_ttf(path, size, wanted):
+    if size <= 0:
+        raise SystemExit(f"{path}: ttf/otf fonts need SIZE (--size <px>)")
+    try:
+        from PIL import Image, ImageDraw, ImageFont
+    except ImportError:
+        raise SystemExit(f"{path}: ttf/otf fonts need pillow (pip install pillow)")
+
+    face = ImageFont.truetype(path, size)
+    ascent, descent = face.getmetrics()
+    glyphs = {}
+    for cp in sorted(wanted):
+        ch = chr(cp)
+        l, t, r, b = face.getbbox(ch, anchor="ls")
+        w, h = max(r - l, 0), max(b - t, 0)
+        rows = []
+        if w and h:
+            im = Image.new("1", (w, h), 0)
+            ImageDraw.Draw(im).text((-l, -t), ch, font=face, fill=1, anchor="ls")
+            rows = [[1 if im.getpixel((x, y)) else 0 for x in range(w)] for y in range(h)]
+        glyphs[cp] = (w, h, round(face.getlength(ch)), l, t, rows)
+    return ascent + descent, glyphs
+
+
+def parse_ranges(spec):
+    cps = set()
+    for part in spec.replace(" ", "").split(","):
+        if not part:
+            continue
+        if "-" in part:
+            a, b = part.split("-", 1)
+            cps.update(range(int(a, 0), int(b, 0) + 1))
+        else:
+            cps.add(int(part, 0))
+    return cps
+
+
+def cmd_font(args):
+    wanted = parse_ranges(args.ranges)
+    ext = os.path.splitext(args.source)[1].lower()
+    if ext == ".bdf":
+        y_adv, glyphs = load_bdf(args.source, wanted)
+    else:
+        y_adv, glyphs = load_ttf(args.source, args.size, wanted)
+    if not glyphs:
+        raise SystemExit(f"{args.source}: no glyphs in the requested ranges")
+
+    cps = sorted(glyphs)
+    bitmap, table = bytearray(), []
+    for cp in cps:
+        w, h, adv, xo, yo, rows = glyphs[cp]
+        if not (0 <= w < 256 and 0 <= h < 256 and 0 <= adv < 256
+                and -128 <= xo < 128 and -128 <= yo < 128):
+            raise SystemExit(f"{args.source}: glyph U+{cp:04X} does not fit the glyph format")
+        offset = len(bitmap)
+        acc, nbits = 0, 0
+        for row in rows:
+            for bit in row:
+                acc = (acc << 1) | bit
+                nbits += 1
+                if nbits == 8:
+                    bitmap.append(acc)
+                    acc, nbits = 0, 0
+        if nbits:
+            bitmap.append(acc << (8 - nbits))
+        table.append((offset, w, h, adv, xo, yo, cp))
+    if len(bitmap) > 0xFFFF:
+        raise SystemExit(f"{args.source}: bitmap exceeds 64 KiB, split the ranges")
+
+    ranges = []
+    for i, cp in enumerate(cps):
+        if ranges and ranges[-1][0] + ranges[-1][1] == cp:
+            ranges[-1][1] += 1
+        else:
+            ranges.append([cp, 1, i])
+
+    ns, name = args.namespace, args.name
+    body = c_array("jpico::u8", f"{name}_bitmap", list(bitmap))
+    body += f"\n\ninline constexpr jpico::graphics::glyph {name}_glyphs[] = {{\n"
+    body += "\n".join(f"    {{{o}, {w}, {h}, {a}, {xo}, {yo}}},  // U+{cp:04X}"
+                      for (o, w, h, a, xo, yo, cp) in table)
+    body += "\n};"
+
+    dense = len(ranges) == 1 and cps[-1] < 256
+    if dense:
+        body += (f"\n\ninline constexpr jpico::graphics::font {name}{{"
+                 f"{name}_bitmap, {name}_glyphs, {cps[0]}, {cps[-1]}, {y_adv}}};")
+        index_size = 0
+    else:
+        body += f"\n\ninline constexpr jpico::graphics::glyph_range {name}_ranges[] = {{\n"
+        body += "\n".join(f"    {{0x{f:X}, {n}, {g}}}," for f, n, g in ranges)
+        body += "\n};"
+        body += (f"\n\ninline constexpr jpico::graphics::font {name}{{"
+                 f"{name}_bitmap, {name}_glyphs, 0, 0, {y_adv}, "
+                 f"{name}_ranges, {len(ranges)}}};")
+        index_size = 8 * len(ranges)
+
+    nbytes = len(bitmap) + 8 * len(table) + index_size
+    detail = f"{len(cps)} glyphs"
+    summary = f"font, {y_adv}px line, {detail} in {len(ranges)} ranges: {nbytes} bytes"
+    write_header(args.output, args.source, summary,
+                 ["jpico/graphics/font.hpp"], ns, body)
+    report(name, "font", detail, nbytes)
+
+
+# --------------------------------------------------------------------------
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    sub = ap.add_subparsers(dest="kind", required=True)
+
+    f = sub.add_parser("font")
+    f.add_argument("--size", type=int, default=0, help="pixel size (ttf only)")
+    f.add_argument("--ranges", default="32-126", help="e.g. 32-126,0xB0,0x2190-0x2193")
+    f.set_defaults(func=cmd_font)
+
+    i = sub.add_parser("image")
+    i.add_argument("--encoding", default="auto", choices=["auto", "raw", "rle", "palette"])
+    i.add_argument("--key", type=lambda v: int(v, 0), default=None,
+                   help="rgb565 color key for transparent pixels")
+    i.add_argument("--alpha", default="none", choices=["none", "a8", "a4"],
+                   help="keep png alpha as a side channel (raw encoding)")
+    i.set_defaults(func=cmd_image)
+
+    for p in (f, i):
+        p.add_argument("--name", required=True)
+        p.add_argument("--source", required=True)
+        p.add_argument("--output", required=True)
+        p.add_argument("--namespace", default="assets")
+
+    args = ap.parse_args()
+    args.func(args)
+
+
+if __name__ == "__main__":
+    main()
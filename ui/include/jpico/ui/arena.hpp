@@ -0,0 +1,62 @@
+#pragma once
+#include <new>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <jpico/result.hpp>
+#include <jpico/types.hpp>
+
+namespace jpico::ui {
+
+// bump allocator over caller-owned memory. nothing is freed individually
+// and destructors never run: reset() drops everything at once, e.g. when
+// switching screens.
+class arena {
+ public:
+  explicit arena(std::span<u8> memory)
+      : base_{memory.data()}, capacity_{memory.size()} {}
+
+  arena(const arena&) = delete;
+  arena& operator=(const arena&) = delete;
+
+  // nullptr when there is no room left
+  void* allocate(usize size, usize align) {
+    usize at = (reinterpret_cast<std::uintptr_t>(base_) + used_ + align - 1) &
+               ~(align - 1);
+    at -= reinterpret_cast<std::uintptr_t>(base_);
+    if (at + size > capacity_) return nullptr;
+    used_ = at + size;
+    return base_ + at;
+  }
+
+  template <typename T, typename... Args>
+  result<T*> make(Args&&... args) {
+    static_assert(std::is_trivially_destructible_v<T>,
+                  "arena objects are never destroyed");
+    void* p = allocate(sizeof(T), alignof(T));
+    if (!p) return fail(error_code::out_of_memory, "arena full");
+    return new (p) T(std::forward<Args>(args)...);
+  }
+
+  // n value-initialized elements
+  template <typename T>
+  result<T*> make_array(usize n) {
+    static_assert(std::is_trivially_destructible_v<T>,
+                  "arena objects are never destroyed");
+    void* p = allocate(sizeof(T) * n, alignof(T));
+    if (!p) return fail(error_code::out_of_memory, "arena full");
+    return new (p) T[n]();
+  }
+
+  void reset() { used_ = 0; }
+
+  usize used() const { return used_; }
+  usize capacity() const { return capacity_; }
+
+ private:
+  u8* base_;
+  usize capacity_;
+  usize used_ = 0;
+};
+
+}  // namespace jpico::ui
@@ -0,0 +1,156 @@
+#pragma once
+#include <span>
+#include <jpico/types.hpp>
+#include <jpico/ui/widget.hpp>
+
+namespace jpico::ui {
+
+// one pixel column of a chart: the sample range it covers
+struct chart_column {
+  i16 lo;
+  i16 hi;
+};
+
+// sweeping strip chart. samples are folded into min/max columns, so a
+// burst faster than the display still shows its peaks, and each column
+// is drawn once as a single vertical span when it completes. the write
+// position sweeps left to right and wraps, with a short blank gap ahead
+// of it, so only new columns are ever drawn and sent; the screen picks
+// them up in update() through paint_pending(). invalidation (range or
+// color changes, moves) repaints the whole chart from the column ring.
+//
+// column storage is the caller's, e.g. arena.make_array<chart_column>(w);
+// columns past the end of it are left blank. pending columns are drawn
+// over anything stacked on top of the chart.
+class strip_chart : public widget {
+ public:
+  static constexpr widget_kind tag = widget_kind::chart;
+  static constexpr u16 gap = 4;
+
+  strip_chart(rect bounds, std::span<chart_column> columns, i16 min, i16 max,
+              u16 samples_per_column = 1)
+      : widget{tag, bounds},
+        columns_{columns.data()},
+        capacity_{static_cast<u16>(columns.size())},
+        min_{min},
+        max_{max},
+        per_column_{samples_per_column ? samples_per_column : u16{1}} {}
+
+  // value range mapped to the chart height
+  void set_range(i16 min, i16 max) {
+    min_ = min;
+    max_ = max;
+    invalidate();
+  }
+
+  // decimation: how many samples make one column
+  void set_samples_per_column(u16 n) { per_column_ = n ? n : 1; }
+
+  // 0 uses the theme's accent color
+  void set_color(u16 color) {
+    color_ = color;
+    invalidate();
+  }
+
+  void push(i16 sample) {
+    if (!taken_) {
+      // start from the previous sample so steep edges stay connected
+      lo_ = hi_ = has_last_ ? last_ : sample;
+    }
+    lo_ = sample < lo_ ? sample : lo_;
+    hi_ = sample > hi_ ? sample : hi_;
+    last_ = sample;
+    has_last_ = true;
+    if (++taken_ < per_column_) return;
+    taken_ = 0;
+
+    u16 w = width();
+    if (!w) return;
+    if (head_ >= w) head_ = 0;  // the chart shrank
+    columns_[head_] = {lo_, hi_};
+    head_ = static_cast<u16>(head_ + 1 == w ? 0 : head_ + 1);
+    if (filled_ < w) ++filled_;
+    // more than a sweep behind: a full repaint is cheaper
+    if (++pending_ >= w) invalidate();
+  }
+
+  void push(std::span<const i16> samples) {
+    for (i16 s : samples) push(s);
+  }
+
+  // blank the chart and restart the sweep at the left edge
+  void clear() {
+    head_ = filled_ = pending_ = taken_ = 0;
+    has_last_ = false;
+    invalidate();
+  }
+
+  template <typename Canvas>
+  void draw(Canvas& c, const theme& t) {
+    u16 w = width();
+    for (u16 i = 0; i < w; ++i) draw_column(c, t, i);
+    pending_ = 0;
+  }
+
+  template <typename Canvas>
+  rect paint_pending(Canvas& c, const theme& t) {
+    u16 w = width();
+    if (!pending_ || !w) return {};
+    u16 n = pending_ + gap < w ? static_cast<u16>(pending_ + gap) : w;
+    u16 first = static_cast<u16>((head_ + w - pending_) % w);
+    for (u16 k = 0; k < n; ++k) draw_column(c, t, (first + k) % w);
+    pending_ = 0;
+    // a wrapped sweep touches both ends
+    rect r = bounds();
+    if (first + n <= w) {
+      r.origin.x = static_cast<i16>(r.x() + first);
+      r.dims.w = n;
+    } else {
+      r.dims.w = w;
+    }
+    return r;
+  }
+
+ private:
+  u16 width() const {
+    return bounds().width() < capacity_ ? bounds().width() : capacity_;
+  }
+
+  i16 y_of(i16 v) const {
+    rect r = bounds();
+    i32 span = max_ - min_;
+    if (span <= 0 || r.height() < 2) return r.y();
+    v = detail::clamp(v, min_ < max_ ? min_ : max_, max_ > min_ ? max_ : min_);
+    return static_cast<i16>(r.bottom() - 1 -
+                            i32{v - min_} * (r.height() - 1) / span);
+  }
+
+  // column i cleared, then its span drawn unless it is empty or in the gap
+  template <typename Canvas>
+  void draw_column(Canvas& c, const theme& t, u16 i) const {
+    rect r = bounds();
+    i16 x = static_cast<i16>(r.x() + i);
+    c.fill_rect(x, r.y(), 1, r.height(), t.background);
+    u16 w = width();
+    u16 ahead = static_cast<u16>((i + w - head_) % w);
+    if (ahead < gap) return;
+    if (filled_ < w && i >= head_) return;  // first sweep not there yet
+    i16 y0 = y_of(columns_[i].hi), y1 = y_of(columns_[i].lo);
+    c.fill_rect(x, y0, 1, y1 - y0 + 1, color_ ? color_ : t.accent);
+  }
+
+  chart_column* columns_;
+  u16 capacity_;
+  i16 min_, max_;
+  u16 per_column_;
+  u16 color_ = 0;
+
+  u16 head_ = 0;     // next column to write
+  u16 filled_ = 0;   // columns written since the last clear, up to width
+  u16 pending_ = 0;  // written but not drawn yet
+  u16 taken_ = 0;    // samples folded into the current column
+  i16 lo_ = 0, hi_ = 0, last_ = 0;
+  bool has_last_ = false;
+};
+
+}  // namespace jpico::ui
@@ -0,0 +1,237 @@
+#pragma once
+#include <bit>
+#include <type_traits>
+#include <utility>
+#include <jpico/concepts.hpp>
+#include <jpico/graphics/canvas.hpp>
+#include <jpico/graphics/damage.hpp>
+#include <jpico/result.hpp>
+#include <jpico/types.hpp>
+#include <jpico/ui/arena.hpp>
+#include <jpico/ui/chart.hpp>
+#include <jpico/ui/widget.hpp>
+
+namespace jpico::ui {
+
+// call f with w cast to its concrete type
+template <typename F>
+decltype(auto) visit(widget& w, F&& f) {
+  switch (w.kind()) {
+    case widget_kind::label:
+      return f(static_cast<label&>(w));
+    case widget_kind::button:
+      return f(static_cast<button&>(w));
+    case widget_kind::slider:
+      return f(static_cast<slider&>(w));
+    case widget_kind::gauge:
+      return f(static_cast<gauge&>(w));
+    case widget_kind::list:
+      return f(static_cast<list&>(w));
+    case widget_kind::chart:
+      break;
+  }
+  return f(static_cast<strip_chart&>(w));
+}
+
+// owns a set of widgets allocated from an arena and keeps the display in
+// sync with them. update() collects the bounds of changed widgets into a
+// damage list and repaints each merged rect once, under clip, drawing only
+// the widgets that overlap it; a framebuffered canvas then sends just those
+// rects. touches are routed through a grid of 32 px cells holding a bitmask
+// of the widgets that overlap each cell. later widgets draw on top and win
+// hit tests. widgets that append (strip_chart) also get to draw just
+// their new parts on every update.
+//
+//   static u8 memory[2048];
+//   ui::arena arena{memory};
+//   ui::screen<> ui{arena};
+//   ui.init(320, 240);
+//   auto ok = ui.add<ui::button>(rect{{10, 10}, {80, 30}}, "ok");
+//   while (true) {
+//     ui.poll(touch);
+//     ui.update(canvas);
+//   }
+template <usize MaxWidgets = 32, usize MaxDamage = 8>
+class screen {
+  static_assert(MaxWidgets <= 64, "hit-test masks hold at most 64 widgets");
+
+ public:
+  using mask = std::conditional_t<(MaxWidgets <= 32), u32, u64>;
+  static constexpr u8 cell_shift = 5;
+
+  explicit screen(arena& memory, const theme& t = {})
+      : arena_{memory}, theme_{t} {}
+
+  screen(const screen&) = delete;
+  screen& operator=(const screen&) = delete;
+
+  // allocates the hit-test grid for a w x h screen
+  result<void> init(u16 w, u16 h) {
+    cols_ = static_cast<u16>((w + (1 << cell_shift) - 1) >> cell_shift);
+    rows_ = static_cast<u16>((h + (1 << cell_shift) - 1) >> cell_shift);
+    auto cells = arena_.make_array<mask>(static_cast<usize>(cols_) * rows_);
+    if (!cells) return std::unexpected{cells.error()};
+    cells_ = *cells;
+    size_ = {w, h};
+    return ok();
+  }
+
+  // construct a widget in the arena and add it on top
+  template <typename W, typename... Args>
+  result<W*> add(Args&&... args) {
+    static_assert(std::is_base_of_v<widget, W>);
+    if (count_ == MaxWidgets)
+      return fail(error_code::out_of_memory, "screen full");
+    auto w = arena_.make<W>(std::forward<Args>(args)...);
+    if (!w) return w;
+    (*w)->id_ = count_;
+    widgets_[count_++] = *w;
+    return w;
+  }
+
+  usize count() const { return count_; }
+  widget& operator[](usize i) { return *widgets_[i]; }
+
+  const theme& current_theme() const { return theme_; }
+  void set_theme(const theme& t) {
+    theme_ = t;
+    invalidate_all();
+  }
+
+  // repaint a region that is not tied to one widget
+  void invalidate(rect r) { damage_.add(r.intersection(screen_rect())); }
+  void invalidate_all() { damage_.add(screen_rect()); }
+
+  // topmost enabled, visible widget under p, as of the last update()
+  widget* hit(point p) const {
+    if (!screen_rect().contains(p) || !cells_) return nullptr;
+    mask m = cells_[(p.y >> cell_shift) * cols_ + (p.x >> cell_shift)];
+    while (m) {
+      u8 id = static_cast<u8>(std::bit_width(m) - 1);
+      m &= ~(mask{1} << id);
+      widget* w = widgets_[id];
+      if (w->enabled_ && w->drawn_.contains(p)) return w;
+    }
+    return nullptr;
+  }
+
+  // feed touch state, once per frame. a touch belongs to the widget it
+  // started on until released.
+  template <touch_source T>
+  void poll(T& touch) {
+    if (touch.touched()) {
+      touch_down(touch.read());
+    } else {
+      touch_up();
+    }
+  }
+
+  void touch_down(point p) {
+    last_ = p;
+    if (pressing_) {
+      if (active_) visit(*active_, [&](auto& w) { w.drag(p); });
+      return;
+    }
+    pressing_ = true;
+    active_ = hit(p);
+    if (active_) visit(*active_, [&](auto& w) { w.press(p); });
+  }
+
+  void touch_up() {
+    if (active_) visit(*active_, [&](auto& w) { w.release(last_); });
+    active_ = nullptr;
+    pressing_ = false;
+  }
+
+  // repaint whatever changed since the last call. returns the bounds of
+  // everything repainted, empty when nothing was.
+  template <display D, typename S>
+  rect update(graphics::canvas<D, S>& c) {
+    rect total = paint_pending(c);
+    for (usize i = 0; i < count_; ++i) {
+      widget& w = *widgets_[i];
+      if (!w.dirty_) continue;
+      rect now = w.visible_ ? w.bounds_.intersection(screen_rect()) : rect{};
+      damage_.add(w.drawn_);
+      damage_.add(now);
+      if (now != w.drawn_) reindex(w, now);
+      w.dirty_ = false;
+    }
+    if (damage_.empty()) return total;
+
+    total = total.united(damage_.bounds());
+    for (rect r : damage_) {
+      if (!c.push_clip(r)) continue;
+      c.fill(theme_.background);
+      for (usize i = 0; i < count_; ++i) {
+        widget& w = *widgets_[i];
+        if (!w.drawn_.intersects(r) || !c.push_clip(w.drawn_)) continue;
+        visit(w, [&](auto& x) { x.draw(c, theme_); });
+        c.pop_clip();
+      }
+      c.pop_clip();
+      c.flush_rect(r);
+    }
+    damage_.clear();
+    return total;
+  }
+
+ private:
+  rect screen_rect() const { return {{0, 0}, size_}; }
+
+  // let appending widgets draw their new parts in place, each sent as
+  // one rect. dirty widgets are skipped: the full repaint that follows
+  // draws their pending parts too.
+  template <display D, typename S>
+  rect paint_pending(graphics::canvas<D, S>& c) {
+    rect total;
+    for (usize i = 0; i < count_; ++i) {
+      widget& w = *widgets_[i];
+      if (w.dirty_ || w.drawn_.empty() || !c.push_clip(w.drawn_)) continue;
+      rect r = visit(w, [&](auto& x) { return x.paint_pending(c, theme_); });
+      c.pop_clip();
+      r = r.intersection(w.drawn_);
+      if (r.empty()) continue;
+      c.flush_rect(r);
+      total = total.united(r);
+    }
+    return total;
+  }
+
+  // move w's bit from the cells under its old rect to those under now
+  void reindex(widget& w, rect now) {
+    mask bit = mask{1} << w.id_;
+    mark(w.drawn_, bit, false);
+    mark(now, bit, true);
+    w.drawn_ = now;
+  }
+
+  void mark(rect r, mask bit, bool set) {
+    if (r.empty() || !cells_) return;
+    u16 cx0 = static_cast<u16>(r.x() >> cell_shift);
+    u16 cy0 = static_cast<u16>(r.y() >> cell_shift);
+    u16 cx1 = static_cast<u16>((r.right() - 1) >> cell_shift);
+    u16 cy1 = static_cast<u16>((r.bottom() - 1) >> cell_shift);
+    for (u16 cy = cy0; cy <= cy1; ++cy) {
+      for (u16 cx = cx0; cx <= cx1; ++cx) {
+        mask& m = cells_[cy * cols_ + cx];
+        m = set ? m | bit : m & ~bit;
+      }
+    }
+  }
+
+  arena& arena_;
+  theme theme_;
+  widget* widgets_[MaxWidgets] = {};
+  u8 count_ = 0;
+  mask* cells_ = nullptr;
+  u16 cols_ = 0;
+  u16 rows_ = 0;
+  size size_;
+  graphics::damage_list<MaxDamage> damage_;
+  widget* active_ = nullptr;
+  point last_;
+  bool pressing_ = false;
+};
+
+}  // namespace jpico::ui
@@ -0,0 +1,418 @@
+#pragma once
+#include <jpico/color.hpp>
+#include <jpico/format.hpp>
+#include <jpico/graphics/font.hpp>
+#include <jpico/graphics/text.hpp>
+#include <jpico/types.hpp>
+
+namespace jpico::ui {
+
+struct theme {
+  u16 background = colors::black.raw;
+  u16 surface = colors::dark_gray.raw;
+  u16 pressed = colors::gray.raw;
+  u16 text = colors::white.raw;
+  u16 accent = colors::cyan.raw;
+  const graphics::font* font = nullptr;  // builtin 5x7 when null
+  u8 text_size = 1;
+};
+
+using align = graphics::text_align;
+
+enum class widget_kind : u8 { label, button, slider, gauge, list, chart };
+
+class widget;
+using event_fn = void (*)(widget& w, void* ctx);
+
+namespace detail {
+
+// text in r, wrapped at word boundaries, centered vertically, clipped.
+// the canvas's own text settings are put back afterwards.
+template <typename Canvas>
+void draw_text(Canvas& c, const theme& t, rect r, const char* s, u16 color,
+               align a = align::left) {
+  if (!s || !*s) return;
+  graphics::text_style saved = c.current_text_style();
+  u16 fg = c.text_color(), bg = c.text_background();
+  c.set_font(t.font);
+  c.set_text_size(t.text_size);
+  c.set_text_color(color);
+  c.set_text_background(color);  // transparent: the screen painted the bg
+  c.draw_text(r, s, a, graphics::text_valign::middle);
+  c.set_font(saved.face);
+  c.set_text_size(saved.sx, saved.sy);
+  c.set_text_color(fg);
+  c.set_text_background(bg);
+}
+
+inline i16 clamp(i32 v, i16 lo, i16 hi) {
+  return static_cast<i16>(v < lo ? lo : v > hi ? hi : v);
+}
+
+}  // namespace detail
+
+// common widget state. concrete widgets derive from it and the screen
+// dispatches on kind() instead of through a vtable, so widget code is not
+// tied to a canvas type and arena objects stay trivially destructible.
+//
+// changes only mark the widget dirty; the screen repaints the old and new
+// bounds on its next update(). new bounds become hit-testable then too.
+class widget {
+ public:
+  widget_kind kind() const { return kind_; }
+  rect bounds() const { return bounds_; }
+  bool visible() const { return visible_; }
+  bool enabled() const { return enabled_; }
+  bool dirty() const { return dirty_; }
+
+  void set_bounds(rect r) {
+    if (r == bounds_) return;
+    bounds_ = r;
+    invalidate();
+  }
+
+  void show(bool on) {
+    if (on == visible_) return;
+    visible_ = on;
+    invalidate();
+  }
+
+  // disabled widgets are drawn but ignore touches
+  void enable(bool on) {
+    if (on == enabled_) return;
+    enabled_ = on;
+    invalidate();
+  }
+
+  void invalidate() { dirty_ = true; }
+
+  // touch hooks, overridden by hiding in interactive widgets
+  void press(point) {}
+  void drag(point) {}
+  void release(point) {}
+
+  // incremental drawing outside of invalidation, for widgets that append
+  // (charts). draws whatever is pending and returns the region touched.
+  template <typename Canvas>
+  rect paint_pending(Canvas&, const theme&) {
+    return {};
+  }
+
+ protected:
+  widget(widget_kind kind, rect bounds) : bounds_{bounds}, kind_{kind} {}
+
+ private:
+  template <usize, usize>
+  friend class screen;
+
+  rect bounds_;
+  rect drawn_;  // bounds at the last update, empty while hidden
+  widget_kind kind_;
+  u8 id_ = 0;
+  bool dirty_ = true;
+  bool visible_ = true;
+  bool enabled_ = true;
+};
+
+class label : public widget {
+ public:
+  static constexpr widget_kind tag = widget_kind::label;
+
+  label(rect bounds, const char* text, align a = align::left)
+      : widget{tag, bounds}, text_{text}, align_{a} {}
+
+  // the string is not copied and must outlive the label
+  void set_text(const char* text) {
+    if (text == text_) return;
+    text_ = text;
+    invalidate();
+  }
+
+  // 0 uses the theme's text color
+  void set_color(u16 color) {
+    color_ = color;
+    invalidate();
+  }
+
+  const char* text() const { return text_; }
+
+  template <typename Canvas>
+  void draw(Canvas& c, const theme& t) const {
+    detail::draw_text(c, t, bounds(), text_, color_ ? color_ : t.text, align_);
+  }
+
+ private:
+  const char* text_;
+  u16 color_ = 0;
+  align align_;
+};
+
+class button : public widget {
+ public:
+  static constexpr widget_kind tag = widget_kind::button;
+
+  button(rect bounds, const char* text) : widget{tag, bounds}, text_{text} {}
+
+  void set_text(const char* text) {
+    text_ = text;
+    invalidate();
+  }
+
+  // runs when a touch that started on the button is released over it
+  void on_click(event_fn fn, void* ctx = nullptr) {
+    click_ = fn;
+    ctx_ = ctx;
+  }
+
+  // 0 uses the theme's surface color
+  void set_fill(u16 color) {
+    fill_ = color;
+    invalidate();
+  }
+
+  u16 fill() const { return fill_; }
+  bool pressed() const { return pressed_; }
+
+  void press(point) { set_pressed(true); }
+  void drag(point p) { set_pressed(bounds().contains(p)); }
+  void release(point p) {
+    bool click = pressed_ && bounds().contains(p);
+    set_pressed(false);
+    if (click && click_) click_(*this, ctx_);
+  }
+
+  template <typename Canvas>
+  void draw(Canvas& c, const theme& t) const {
+    rect r = bounds();
+    c.fill_round_rect(r.x(), r.y(), r.width(), r.height(), 4,
+                      pressed_ ? t.pressed : fill_ ? fill_ : t.surface);
+    detail::draw_text(c, t, r, text_, enabled() ? t.text : t.pressed,
+                      align::center);
+  }
+
+ private:
+  void set_pressed(bool on) {
+    if (on == pressed_) return;
+    pressed_ = on;
+    invalidate();
+  }
+
+  const char* text_;
+  u16 fill_ = 0;
+  event_fn click_ = nullptr;
+  void* ctx_ = nullptr;
+  bool pressed_ = false;
+};
+
+// horizontal track with a square knob, dragged or tapped to a value
+class slider : public widget {
+ public:
+  static constexpr widget_kind tag = widget_kind::slider;
+
+  slider(rect bounds, i16 min, i16 max, i16 value)
+      : widget{tag, bounds},
+        min_{min},
+        max_{max},
+        value_{detail::clamp(value, min, max)} {}
+
+  // clamped to the range; the change callback only fires for touches
+  void set_value(i16 v) {
+    v = detail::clamp(v, min_, max_);
+    if (v == value_) return;
+    value_ = v;
+    invalidate();
+  }
+
+  i16 value() const { return value_; }
+
+  void on_change(event_fn fn, void* ctx = nullptr) {
+    change_ = fn;
+    ctx_ = ctx;
+  }
+
+  void press(point p) { drag(p); }
+  void drag(point p) {
+    i16 before = value_;
+    set_value(value_at(p.x));
+    if (value_ != before && change_) change_(*this, ctx_);
+  }
+
+  template <typename Canvas>
+  void draw(Canvas& c, const theme& t) const {
+    rect r = bounds();
+    i16 k = knob();
+    i16 kx = knob_x();
+    i16 ty = static_cast<i16>(r.y() + r.height() / 2 - 2);
+    c.fill_rect(r.x(), ty, kx - r.x(), 4, enabled() ? t.accent : t.pressed);
+    c.fill_rect(kx, ty, r.right() - kx, 4, t.surface);
+    c.fill_round_rect(kx, r.y(), k, k, static_cast<u16>(k / 4), t.text);
+  }
+
+ private:
+  i16 knob() const { return static_cast<i16>(bounds().height()); }
+  i16 travel() const {
+    i16 t = static_cast<i16>(bounds().width() - knob());
+    return t > 0 ? t : 1;
+  }
+
+  i16 knob_x() const {
+    if (max_ == min_) return bounds().x();
+    return static_cast<i16>(bounds().x() +
+                            i32{value_ - min_} * travel() / (max_ - min_));
+  }
+
+  i16 value_at(i16 x) const {
+    i32 pos = x - bounds().x() - knob() / 2;
+    i32 span = max_ - min_;
+    return detail::clamp(min_ + (pos * span + travel() / 2) / travel(), min_,
+                         max_);
+  }
+
+  i16 min_, max_, value_;
+  event_fn change_ = nullptr;
+  void* ctx_ = nullptr;
+};
+
+// 270 degree arc dial with the value printed in the middle
+class gauge : public widget {
+ public:
+  static constexpr widget_kind tag = widget_kind::gauge;
+
+  gauge(rect bounds, i16 min, i16 max, i16 value)
+      : widget{tag, bounds},
+        min_{min},
+        max_{max},
+        value_{detail::clamp(value, min, max)} {}
+
+  void set_value(i16 v) {
+    v = detail::clamp(v, min_, max_);
+    if (v == value_) return;
+    value_ = v;
+    invalidate();
+  }
+
+  i16 value() const { return value_; }
+
+  template <typename Canvas>
+  void draw(Canvas& c, const theme& t) const {
+    rect r = bounds();
+    i16 cx = static_cast<i16>(r.x() + r.width() / 2);
+    i16 cy = static_cast<i16>(r.y() + r.height() / 2);
+    u16 side = r.width() < r.height() ? r.width() : r.height();
+    u16 radius = static_cast<u16>(side / 2 - 1);
+    u16 thick = static_cast<u16>(radius / 4 + 1);
+    i16 sweep = 0;
+    if (max_ != min_)
+      sweep = static_cast<i16>(i32{value_ - min_} * 270 / (max_ - min_));
+    i16 split = static_cast<i16>(135 + sweep);
+    if (sweep > 0) c.arc(cx, cy, radius, 135, split, t.accent, thick);
+    if (sweep < 270) c.arc(cx, cy, radius, split, 405, t.surface, thick);
+    char text[8];
+    buffer_sink out{text};
+    format_to(out, "{}", value_);
+    detail::draw_text(c, t, r, out.c_str(), t.text, align::center);
+  }
+
+ private:
+  i16 min_, max_, value_;
+};
+
+// scrollable column of strings. a tap selects a row, a vertical drag
+// scrolls by whole rows.
+class list : public widget {
+ public:
+  static constexpr widget_kind tag = widget_kind::list;
+
+  // items are not copied and must outlive the list
+  list(rect bounds, const char* const* items, u16 count, u8 row_height)
+      : widget{tag, bounds},
+        items_{items},
+        count_{count},
+        row_h_{row_height ? row_height : u8{1}} {}
+
+  void set_items(const char* const* items, u16 count) {
+    items_ = items;
+    count_ = count;
+    first_ = 0;
+    selected_ = -1;
+    invalidate();
+  }
+
+  // -1 for none
+  i16 selected() const { return selected_; }
+  void select(i16 index) {
+    if (index >= count_) index = -1;
+    if (index == selected_) return;
+    selected_ = index;
+    invalidate();
+  }
+
+  void on_select(event_fn fn, void* ctx = nullptr) {
+    select_ = fn;
+    ctx_ = ctx;
+  }
+
+  u16 first() const { return first_; }
+  void scroll_to(u16 first) {
+    u16 rows = visible_rows();
+    u16 top = count_ > rows ? static_cast<u16>(count_ - rows) : 0;
+    if (first > top) first = top;
+    if (first == first_) return;
+    first_ = first;
+    invalidate();
+  }
+
+  void press(point p) {
+    press_y_ = p.y;
+    press_first_ = first_;
+    scrolled_ = false;
+  }
+
+  void drag(point p) {
+    i32 rows = (press_y_ - p.y) / row_h_;
+    if (!rows && !scrolled_) return;
+    scrolled_ = true;
+    scroll_to(static_cast<u16>(detail::clamp(press_first_ + rows, 0, 0x7FFF)));
+  }
+
+  void release(point p) {
+    if (scrolled_ || !bounds().contains(p)) return;
+    i32 row = first_ + (p.y - bounds().y()) / row_h_;
+    if (row >= count_) return;
+    select(static_cast<i16>(row));
+    if (select_) select_(*this, ctx_);
+  }
+
+  template <typename Canvas>
+  void draw(Canvas& c, const theme& t) const {
+    rect r = bounds();
+    for (u16 i = 0; i < visible_rows() && first_ + i < count_; ++i) {
+      rect row{{r.x(), static_cast<i16>(r.y() + i * row_h_)},
+               {r.width(), row_h_}};
+      if (first_ + i == selected_)
+        c.fill_rect(row.x(), row.y(), row.width(), row.height(), t.accent);
+      row.origin.x = static_cast<i16>(row.origin.x + 2);
+      row.dims.w = static_cast<u16>(row.dims.w - 2);
+      detail::draw_text(c, t, row, items_[first_ + i],
+                        first_ + i == selected_ ? t.background : t.text);
+    }
+  }
+
+ private:
+  u16 visible_rows() const {
+    return static_cast<u16>((bounds().height() + row_h_ - 1) / row_h_);
+  }
+
+  const char* const* items_;
+  u16 count_;
+  u8 row_h_;
+  u16 first_ = 0;
+  i16 selected_ = -1;
+  i16 press_y_ = 0;
+  u16 press_first_ = 0;
+  bool scrolled_ = false;
+  event_fn select_ = nullptr;
+  void* ctx_ = nullptr;
+};
+
+}  // namespace jpico::ui